@@ -0,0 +1,229 @@
+#include <cstring>
+
+#include "JavascriptArrayBuffer.h"
+#include "JavascriptContext.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Noesis { namespace Javascript {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static ArrayBufferKind GetViewKind(Local<ArrayBufferView> view)
+{
+	if (view->IsDataView()) return kDataView;
+	if (view->IsInt8Array()) return kInt8Array;
+	if (view->IsUint8Array()) return kUint8Array;
+	if (view->IsUint8ClampedArray()) return kUint8ClampedArray;
+	if (view->IsInt16Array()) return kInt16Array;
+	if (view->IsUint16Array()) return kUint16Array;
+	if (view->IsInt32Array()) return kInt32Array;
+	if (view->IsUint32Array()) return kUint32Array;
+	if (view->IsFloat32Array()) return kFloat32Array;
+	if (view->IsFloat64Array()) return kFloat64Array;
+	if (view->IsBigInt64Array()) return kBigInt64Array;
+	if (view->IsBigUint64Array()) return kBigUint64Array;
+	// Views we don't know of (e.g. Float16Array) are exposed as bytes.
+	return kDataView;
+}
+
+static System::Type^ GetElementType(ArrayBufferKind kind)
+{
+	switch (kind)
+	{
+	case kInt8Array: return System::SByte::typeid;
+	case kInt16Array: return System::Int16::typeid;
+	case kUint16Array: return System::UInt16::typeid;
+	case kInt32Array: return System::Int32::typeid;
+	case kUint32Array: return System::UInt32::typeid;
+	case kFloat32Array: return System::Single::typeid;
+	case kFloat64Array: return System::Double::typeid;
+	case kBigInt64Array: return System::Int64::typeid;
+	case kBigUint64Array: return System::UInt64::typeid;
+	default: return System::Byte::typeid;
+	}
+}
+
+static size_t GetElementSize(ArrayBufferKind kind)
+{
+	switch (kind)
+	{
+	case kInt16Array: case kUint16Array: return 2;
+	case kInt32Array: case kUint32Array: case kFloat32Array: return 4;
+	case kFloat64Array: case kBigInt64Array: case kBigUint64Array: return 8;
+	default: return 1;
+	}
+}
+
+template<typename B>
+static Local<Value> NewView(ArrayBufferKind kind, Local<B> buffer, size_t byteOffset, size_t byteLength)
+{
+	size_t length = byteLength / GetElementSize(kind);
+	switch (kind)
+	{
+	case kDataView: return DataView::New(buffer, byteOffset, byteLength);
+	case kInt8Array: return Int8Array::New(buffer, byteOffset, length);
+	case kUint8Array: return Uint8Array::New(buffer, byteOffset, length);
+	case kUint8ClampedArray: return Uint8ClampedArray::New(buffer, byteOffset, length);
+	case kInt16Array: return Int16Array::New(buffer, byteOffset, length);
+	case kUint16Array: return Uint16Array::New(buffer, byteOffset, length);
+	case kInt32Array: return Int32Array::New(buffer, byteOffset, length);
+	case kUint32Array: return Uint32Array::New(buffer, byteOffset, length);
+	case kFloat32Array: return Float32Array::New(buffer, byteOffset, length);
+	case kFloat64Array: return Float64Array::New(buffer, byteOffset, length);
+	case kBigInt64Array: return BigInt64Array::New(buffer, byteOffset, length);
+	default: return BigUint64Array::New(buffer, byteOffset, length);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+JavascriptArrayBuffer::JavascriptArrayBuffer(Local<Value> iValue)
+{
+	if (iValue->IsArrayBufferView())
+	{
+		Local<ArrayBufferView> view = iValue.As<ArrayBufferView>();
+		Local<ArrayBuffer> buffer = view->Buffer();
+		mBackingStore = new std::shared_ptr<BackingStore>(buffer->GetBackingStore());
+		mByteOffset = view->ByteOffset();
+		mByteLength = view->ByteLength();
+		mKind = GetViewKind(view);
+		mSection = nullptr;
+	}
+	else if (iValue->IsArrayBuffer() || iValue->IsSharedArrayBuffer())
+	{
+		mBackingStore = new std::shared_ptr<BackingStore>(iValue->IsArrayBuffer() ? iValue.As<ArrayBuffer>()->GetBackingStore() : iValue.As<SharedArrayBuffer>()->GetBackingStore());
+		mByteOffset = 0;
+		mByteLength = (*mBackingStore)->ByteLength();
+		mKind = kArrayBuffer;
+		mSection = nullptr;
+	}
+	else
+		throw gcnew System::ArgumentException("Trying to use non-ArrayBuffer as ArrayBuffer");
+}
+
+JavascriptArrayBuffer::JavascriptArrayBuffer(std::shared_ptr<BackingStore> iBackingStore)
+{
+	mBackingStore = new std::shared_ptr<BackingStore>(iBackingStore);
+	mByteOffset = 0;
+	mByteLength = iBackingStore->ByteLength();
+	mKind = kArrayBuffer;
+	mSection = nullptr;
+}
+
+JavascriptArrayBuffer::JavascriptArrayBuffer(MappedFileSection *iSection, std::shared_ptr<BackingStore> iBackingStore)
+{
+	mBackingStore = new std::shared_ptr<BackingStore>(iBackingStore);
+	mByteOffset = 0;
+	mByteLength = iBackingStore->ByteLength();
+	mKind = kArrayBuffer;
+	mSection = iSection;
+}
+
+JavascriptArrayBuffer::~JavascriptArrayBuffer()
+{
+	this->!JavascriptArrayBuffer();
+}
+
+JavascriptArrayBuffer::!JavascriptArrayBuffer()
+{
+	// Dropping the last reference to a backing store is allowed on any thread.
+	delete mBackingStore;
+	mBackingStore = nullptr;
+	if (mSection != nullptr)
+	{
+		mSection->Release();
+		mSection = nullptr;
+	}
+}
+
+System::IntPtr JavascriptArrayBuffer::Data::get()
+{
+	CheckNotDisposed();
+	return System::IntPtr((char *)(*mBackingStore)->Data() + mByteOffset);
+}
+
+long long JavascriptArrayBuffer::ByteLength::get()
+{
+	return mByteLength;
+}
+
+long long JavascriptArrayBuffer::Length::get()
+{
+	return mByteLength / GetElementSize(mKind);
+}
+
+System::Type^ JavascriptArrayBuffer::ElementType::get()
+{
+	return GetElementType(mKind);
+}
+
+System::Array^ JavascriptArrayBuffer::ToArray()
+{
+	CheckNotDisposed();
+	if (Length > System::Int32::MaxValue)
+		throw gcnew System::InvalidOperationException("The buffer is too large for a .NET array");
+
+	System::Array^ result = System::Array::CreateInstance(ElementType, (int)Length);
+	CopyTo(result, mByteLength);
+	return result;
+}
+
+generic <typename T>
+cli::array<T>^ JavascriptArrayBuffer::ToArray()
+{
+	CheckNotDisposed();
+	size_t elementSize = System::Runtime::CompilerServices::Unsafe::SizeOf<T>();
+	size_t length = mByteLength / elementSize;
+	if (length > System::Int32::MaxValue)
+		throw gcnew System::InvalidOperationException("The buffer is too large for a .NET array");
+
+	cli::array<T>^ result = gcnew cli::array<T>((int)length);
+	CopyTo(result, length * elementSize);
+	return result;
+}
+
+void JavascriptArrayBuffer::CopyTo(System::Array^ target, size_t byteLength)
+{
+	if (byteLength == 0)
+		return;
+
+	System::Runtime::InteropServices::GCHandle handle = System::Runtime::InteropServices::GCHandle::Alloc(target, System::Runtime::InteropServices::GCHandleType::Pinned);
+	try
+	{
+		memcpy(handle.AddrOfPinnedObject().ToPointer(), (char *)(*mBackingStore)->Data() + mByteOffset, byteLength);
+	}
+	finally
+	{
+		handle.Free();
+	}
+}
+
+Local<Value> JavascriptArrayBuffer::ToV8(Isolate *isolate)
+{
+	CheckNotDisposed();
+
+	// A mapped file is only shared with other contexts as long as nobody writes to it.
+	if (mSection != nullptr)
+		return ArrayBuffer::New(isolate, JavascriptContext::GetCurrent()->GetMappedFileView(mSection));
+
+	// Views over a SharedArrayBuffer have to be recreated over a SharedArrayBuffer.
+	if ((*mBackingStore)->IsShared())
+	{
+		Local<SharedArrayBuffer> buffer = SharedArrayBuffer::New(isolate, *mBackingStore);
+		if (mKind == kArrayBuffer)
+			return buffer;
+		return NewView(mKind, buffer, mByteOffset, mByteLength);
+	}
+
+	Local<ArrayBuffer> buffer = ArrayBuffer::New(isolate, *mBackingStore);
+	if (mKind == kArrayBuffer)
+		return buffer;
+	return NewView(mKind, buffer, mByteOffset, mByteLength);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} } // namespace Noesis::Javascript
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,123 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+
+#include <v8.h>
+#include <atomic>
+#include <memory>
+
+using namespace v8;
+
+//////////////////////////////////////////////////////////////////////////
+
+namespace Noesis { namespace Javascript {
+
+//////////////////////////////////////////////////////////////////////////
+
+// What kind of JavaScript object a JavascriptArrayBuffer was converted
+// from, so we can recreate the same kind when it is passed back.
+enum ArrayBufferKind
+{
+	kArrayBuffer,
+	kDataView,
+	kInt8Array,
+	kUint8Array,
+	kUint8ClampedArray,
+	kInt16Array,
+	kUint16Array,
+	kInt32Array,
+	kUint32Array,
+	kFloat32Array,
+	kFloat64Array,
+	kBigInt64Array,
+	kBigUint64Array
+};
+
+// A file mapped read-only by JavascriptContext::MapFile().  Every context,
+// and the .NET side, gets its own copy-on-write view of it: the views share
+// the file's clean pages, but a write stays private to whoever made it.
+// Reference counted, because views outlive the JavascriptArrayBuffer that
+// created them, and released on whatever thread drops the last one.
+class MappedFileSection
+{
+public:
+	// Takes over the mapping handle.
+	MappedFileSection(void *mapping, size_t length) : mMapping(mapping), mLength(length), mReferences(1) {}
+
+	// Maps a new view, or returns null with the Win32 error code in `error`.
+	std::unique_ptr<BackingStore> NewView(unsigned long *error);
+
+	void AddRef() { mReferences++; }
+
+	void Release();
+
+private:
+	void *mMapping;
+	size_t mLength;
+	std::atomic<int> mReferences;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// JavascriptArrayBuffer
+//
+// Wraps around the memory of a JS ArrayBuffer, SharedArrayBuffer, typed
+// array or DataView when passed back to C#.  The memory is not copied:
+// this object holds a reference to V8's backing store, which keeps it
+// alive even after JavaScript has dropped the buffer, until this object
+// is disposed or finalized.  Passing it back to JavaScript yields a new
+// object of the original kind over the same memory, except for read-only
+// mapped files, which each context sees through a view of its own.
+//////////////////////////////////////////////////////////////////////////
+public ref class JavascriptArrayBuffer: public System::IDisposable
+{
+public:
+	~JavascriptArrayBuffer();
+	!JavascriptArrayBuffer();
+
+	// Address of the first byte.  Only valid while this object is alive.
+	property System::IntPtr Data { System::IntPtr get(); }
+
+	property long long ByteLength { long long get(); }
+
+	// Number of elements of ElementType.
+	property long long Length { long long get(); }
+
+	// The .NET equivalent of the typed array's element type, and Byte for
+	// ArrayBuffers and DataViews.
+	property System::Type^ ElementType { System::Type^ get(); }
+
+	// Copies the contents into a new array of ElementType.
+	System::Array^ ToArray();
+
+	// Copies the contents into a new array, reinterpreting the bytes as T.
+	generic <typename T> where T : value class
+	cli::array<T>^ ToArray();
+
+internal:
+	JavascriptArrayBuffer(Local<Value> iValue);
+
+	JavascriptArrayBuffer(std::shared_ptr<BackingStore> iBackingStore);
+
+	// Takes over the caller's reference to the section.  The backing store
+	// is the view used by .NET.
+	JavascriptArrayBuffer(MappedFileSection *iSection, std::shared_ptr<BackingStore> iBackingStore);
+
+	Local<Value> ToV8(Isolate *isolate);
+
+private:
+	void CopyTo(System::Array^ target, size_t byteLength);
+
+	inline void CheckNotDisposed() { if (mBackingStore == nullptr) throw gcnew System::ObjectDisposedException("JavascriptArrayBuffer"); }
+
+	std::shared_ptr<BackingStore> *mBackingStore;
+	MappedFileSection *mSection;
+	size_t mByteOffset;
+	size_t mByteLength;
+	ArrayBufferKind mKind;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+} } // namespace Noesis::Javascript
+
+//////////////////////////////////////////////////////////////////////////
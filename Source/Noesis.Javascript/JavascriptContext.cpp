@@ -26,22 +26,35 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <atomic>
 #include <mutex>
 #include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+#if defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#endif
 #include <msclr\lock.h>
 #include <vcclr.h>
 #include <msclr\marshal.h>
 #include <msclr\marshal_cppstd.h>
 #include <signal.h>
 #include "libplatform/libplatform.h"
+#include "v8-profiler.h"
 
 #include "JavascriptContext.h"
 
+#include "JavascriptArrayBuffer.h"
+
 #include "SystemInterop.h"
 #include "JavascriptException.h"
 #include "JavascriptExternal.h"
 #include "JavascriptFunction.h"
 #include "JavascriptInterop.h"
+#include "JavascriptScript.h"
+#include "JavascriptWasmModule.h"
+#include "JavascriptObjectScope.h"
+#include "JavascriptMemoryCoordinator.h"
 #include "JavascriptStackFrame.h"
 
 using namespace msclr;
@@ -107,15 +120,240 @@ namespace Noesis { namespace Javascript {
         v8::V8::Initialize();
         initialized = true;
 	}
+
+	// Deleter for backing stores over views created by MapFileIntoMemory().
+	void UnmapFile(void *data, size_t length, void *deleter_data)
+	{
+		UnmapViewOfFile(data);
+	}
+
+	// Deleter for backing stores over views created by MappedFileSection::NewView().
+	void UnmapFileSectionView(void *data, size_t length, void *deleter_data)
+	{
+		UnmapViewOfFile(data);
+		((MappedFileSection *)deleter_data)->Release();
+	}
+
+	// Creates a mapping of a whole file.  Read-only mappings are copy-on-write, because ArrayBuffers
+	// can't be read-only and writing to a PAGE_READONLY view would crash the process.  The copied
+	// pages belong to the view they were written through.  Returns null for empty files, and on
+	// failure with the Win32 error code in `error`.
+	HANDLE CreateFileSection(const wchar_t *path, bool readOnly, size_t *length, DWORD *error)
+	{
+		*length = 0;
+		*error = ERROR_SUCCESS;
+
+		HANDLE file = CreateFileW(path, readOnly ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			*error = GetLastError();
+			return nullptr;
+		}
+
+		HANDLE mapping = NULL;
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size))
+			*error = GetLastError();
+		else if ((unsigned long long)size.QuadPart > SIZE_MAX)
+			*error = ERROR_FILE_TOO_LARGE;
+		else if (size.QuadPart > 0)
+		{
+			// The mapping keeps the file open, so we can close our handle right away.
+			mapping = CreateFileMappingW(file, NULL, readOnly ? PAGE_WRITECOPY : PAGE_READWRITE, 0, 0, NULL);
+			if (mapping == NULL)
+				*error = GetLastError();
+			else
+				*length = (size_t)size.QuadPart;
+		}
+		CloseHandle(file);
+		return mapping;
+	}
+
+	// Maps a whole file into memory as a single view.  Returns null for empty files, and on failure
+	// with the Win32 error code in `error`.
+	void *MapFileIntoMemory(const wchar_t *path, bool readOnly, size_t *length, DWORD *error)
+	{
+		HANDLE mapping = CreateFileSection(path, readOnly, length, error);
+		if (mapping == NULL)
+			return nullptr;
+
+		// The view keeps the mapping open.
+		void *view = MapViewOfFile(mapping, readOnly ? FILE_MAP_COPY : FILE_MAP_WRITE, 0, 0, 0);
+		if (view == nullptr)
+		{
+			*error = GetLastError();
+			*length = 0;
+		}
+		CloseHandle(mapping);
+		return view;
+	}
+
+#ifdef V8_ENABLE_SANDBOX
+	// V8 only accepts backing stores inside its sandbox, so mapped files have to be copied into
+	// memory from this allocator.
+	v8::ArrayBuffer::Allocator *sandboxAllocator = nullptr;
+
+	void FreeSandboxCopy(void *data, size_t length, void *deleter_data)
+	{
+		sandboxAllocator->Free(data, length);
+	}
+
+	// Deleter for copies made by MappedFileSection::NewView().
+	void FreeSandboxSectionCopy(void *data, size_t length, void *deleter_data)
+	{
+		sandboxAllocator->Free(data, length);
+		((MappedFileSection *)deleter_data)->Release();
+	}
+
+	std::unique_ptr<v8::BackingStore> CopyIntoSandbox(void *view, size_t length, v8::BackingStore::DeleterCallback deleter = FreeSandboxCopy, void *deleter_data = nullptr)
+	{
+		{
+			std::unique_lock<std::shared_mutex> lock(mutex);
+			if (sandboxAllocator == nullptr)
+				sandboxAllocator = v8::ArrayBuffer::Allocator::NewDefaultAllocator();
+		}
+		void *data = sandboxAllocator->AllocateUninitialized(length);
+		if (data != nullptr)
+			memcpy(data, view, length);
+		UnmapViewOfFile(view);
+		if (data == nullptr)
+			return nullptr;
+		return v8::ArrayBuffer::NewBackingStore(data, length, deleter, deleter_data);
+	}
+#endif
+
+	std::unique_ptr<v8::BackingStore> MappedFileSection::NewView(unsigned long *error)
+	{
+		void *view = MapViewOfFile(mMapping, FILE_MAP_COPY, 0, 0, 0);
+		if (view == nullptr)
+		{
+			*error = GetLastError();
+			return nullptr;
+		}
+		// Each view keeps the section, so that its address identifies the file for as long as the
+		// view is in use.
+		AddRef();
+#ifdef V8_ENABLE_SANDBOX
+		std::unique_ptr<v8::BackingStore> store = CopyIntoSandbox(view, mLength, FreeSandboxSectionCopy, this);
+		if (!store)
+		{
+			Release();
+			*error = ERROR_NOT_ENOUGH_MEMORY;
+		}
+		return store;
+#else
+		return v8::ArrayBuffer::NewBackingStore(view, mLength, UnmapFileSectionView, this);
+#endif
+	}
+
+	void MappedFileSection::Release()
+	{
+		if (--mReferences > 0)
+			return;
+		CloseHandle(mMapping);
+		delete this;
+	}
+
+	// Returns whether all bytes are below 0x80, checking 16 at a time where SSE2 is available.
+	bool IsAscii(const char *data, size_t length)
+	{
+		size_t i = 0;
+#if defined(_M_X64) || defined(_M_IX86)
+		for (; i + 16 <= length; i += 16)
+			if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(data + i))) != 0)
+				return false;
+#endif
+		for (; i < length; i++)
+			if ((unsigned char)data[i] >= 0x80)
+				return false;
+		return true;
+	}
+
+	enum ScriptFileEncoding
+	{
+		kAsciiScript,
+		kUtf16Script,
+		kUtf8Script
+	};
+
+	// A script file mapped by MapFileIntoMemory().  It is shared by the script file cache and by
+	// the source strings of every context that runs it, and unmapped when the last of them
+	// releases it, which may happen on any thread.
+	class MappedScriptSource
+	{
+	public:
+		MappedScriptSource(void *view, size_t length) : mView(view), mReferences(1)
+		{
+			const char *text = (const char *)view;
+			// Byte order marks are not part of the script.
+			if (length >= 2 && (unsigned char)text[0] == 0xFF && (unsigned char)text[1] == 0xFE)
+			{
+				mEncoding = kUtf16Script;
+				mText = text + 2;
+				mTextLength = length - 2;
+				return;
+			}
+			if (length >= 3 && memcmp(text, "\xEF\xBB\xBF", 3) == 0)
+			{
+				text += 3;
+				length -= 3;
+			}
+			// ASCII is the only UTF-8 that V8's one-byte (Latin-1) strings can use as is.
+			mEncoding = IsAscii(text, length) ? kAsciiScript : kUtf8Script;
+			mText = text;
+			mTextLength = length;
+		}
+
+		void AddRef() { mReferences++; }
+
+		void Release()
+		{
+			if (--mReferences > 0)
+				return;
+			if (mView != nullptr)
+				UnmapViewOfFile(mView);
+			delete this;
+		}
+
+		ScriptFileEncoding encoding() const { return mEncoding; }
+
+		const char *text() const { return mText; }
+
+		// In bytes.
+		size_t textLength() const { return mTextLength; }
+
+	private:
+		void *mView;
+		const char *mText;
+		size_t mTextLength;
+		ScriptFileEncoding mEncoding;
+		std::atomic<int> mReferences;
+	};
+
+	// External source string over the text of a MappedScriptSource, keeping it mapped while V8 uses it.
+	template<typename Resource, typename Char>
+	class MappedScriptResource: public Resource
+	{
+	public:
+		MappedScriptResource(MappedScriptSource *source) : mSource(source) { source->AddRef(); }
+
+		~MappedScriptResource() override { mSource->Release(); }
+
+		const Char *data() const override { return (const Char *)mSource->text(); }
+
+		size_t length() const override { return mSource->textLength() / sizeof(Char); }
+
+	private:
+		MappedScriptSource *mSource;
+	};
 #pragma managed(pop)
 
-v8::Local<v8::String> ToV8String(Isolate* isolate, System::String^ value) {
+v8::Local<v8::String> ToV8String(System::String^ value) {
     if (value == nullptr)
         throw gcnew System::ArgumentNullException("value");
-    pin_ptr<const wchar_t> namePtr = PtrToStringChars(value);
-    wchar_t* name = (wchar_t*)namePtr;
 
-    return String::NewFromTwoByte(isolate, (uint16_t*)name, v8::NewStringType::kNormal).ToLocalChecked();
+    // Names of globals tend to be set over and over again.
+    return JavascriptContext::GetCurrent()->GetInternedString(value);
 }
 
 
@@ -144,6 +382,9 @@ void JavascriptContext::FatalErrorCallbackMember(const char* location, const cha
 	}
 }
 
+// Defined with the rest of the module support further down.
+static MaybeLocal<Promise> ImportModuleDynamically(Local<Context> context, Local<Data> host_defined_options, Local<Value> resource_name, Local<String> specifier, Local<FixedArray> import_attributes);
+
 JavascriptContext::JavascriptContext()
 {
     // Certain static operations like setting flags cannot be performed after V8 has been initialized. Since we allow setting flags by
@@ -164,13 +405,39 @@ JavascriptContext::JavascriptContext()
 	v8::Isolate::Scope isolate_scope(isolate);
 
     isolate->SetFatalErrorHandler(FatalErrorCallback);
-
-	mExternals = gcnew System::Collections::Generic::Dictionary<System::Object ^, WrappedJavascriptExternal>();
-	mFunctions = gcnew System::Collections::Generic::Dictionary<int, WrappedJavascriptFunction>();
+    isolate->SetHostImportModuleDynamicallyCallback(ImportModuleDynamically);
+    JavascriptMemoryCoordinator::AddIsolate(isolate);
+
+	mExternals = gcnew System::Collections::Generic::Dictionary<System::Object ^, WrappedJavascriptExternal>(System::Collections::Generic::ReferenceEqualityComparer::Instance);
+	mExternalPool = new JavascriptExternalPool();
+	mObjectScope = nullptr;
+	mFunctions = gcnew System::Collections::Generic::HashSet<System::IntPtr>();
+    mPendingReleases = gcnew System::Collections::Concurrent::ConcurrentQueue<System::ValueTuple<System::IntPtr, long long>>();
+    mPendingScriptReleases = gcnew System::Collections::Concurrent::ConcurrentQueue<System::IntPtr>();
+    mReleaseLatencyTicks = 0;
 	mMethods = gcnew System::Collections::Generic::Dictionary<System::String ^, WrappedMethod>();
+	mMethodTargets = gcnew System::Collections::Generic::List<System::WeakReference^>();
     mTypeToConstructorMapping = gcnew System::Collections::Generic::Dictionary<System::Type ^, System::IntPtr>();
+    mRegexCache = gcnew System::Collections::Generic::Dictionary<System::ValueTuple<System::String^, int>, CachedRegex^>();
+    mRegExpSources = gcnew System::Collections::Generic::Dictionary<System::String^, System::IntPtr>();
+    mRegexCompilationThreshold = 0;
+    mPrimitiveArrayConversion = TypedArrayConversion::None;
+    mInternedStrings = gcnew System::Collections::Generic::Dictionary<System::String^, System::Collections::Generic::LinkedListNode<System::Collections::Generic::KeyValuePair<System::String^, System::IntPtr>>^>();
+    mInternedStringsByUse = gcnew System::Collections::Generic::LinkedList<System::Collections::Generic::KeyValuePair<System::String^, System::IntPtr>>();
+    mStringCacheSize = 1024;
+    mExternalStringThreshold = 0;
+    mExternalObjectSize = 0;
+    mExternalMemory = 0;
+    mFunctionWrapperKey = nullptr;
+    mPendingCompilations = gcnew System::Threading::CountdownEvent(1);
+    mModules = gcnew System::Collections::Generic::Dictionary<System::String^, System::IntPtr>();
+    mModuleIdentifiers = gcnew System::Collections::Generic::Dictionary<int, System::String^>();
+    mResolvedModules = gcnew System::Collections::Generic::Dictionary<System::ValueTuple<System::String^, System::String^>, System::String^>();
+    mMappedFileViews = gcnew System::Collections::Generic::Dictionary<System::IntPtr, System::IntPtr>();
 	HandleScope scope(isolate);
-	mContext = new Persistent<Context>(isolate, Context::New(isolate));
+	Local<Context> context = Context::New(isolate);
+	mContext = new Persistent<Context>(isolate, context);
+	CaptureDateFunctions(context);
     terminateRuns = false;
 }
 
@@ -178,28 +445,19 @@ JavascriptContext::JavascriptContext()
 
 JavascriptContext::~JavascriptContext()
 {
+	// Background compilations use the isolate, so they have to finish before it goes away.
+	mPendingCompilations->Signal();
+	mPendingCompilations->Wait();
+	delete mPendingCompilations;
 	{
 		v8::Locker v8ThreadLock(isolate);
 		v8::Isolate::Scope isolate_scope(isolate);
+		JavascriptMemoryCoordinator::RemoveIsolate(isolate);
 		for each (WrappedJavascriptExternal wrapped in mExternals->Values)
-			delete wrapped.Pointer;
-        // Clean up JavascriptFunction wrappers
-        for each (WrappedJavascriptFunction wrapped in mFunctions->Values)
-        {
-            auto wrapper = wrapped.Pointer;
-            if (wrapper)
-            {
-                if (wrapper->handle && !wrapper->handle->IsEmpty())
-                {
-                    wrapper->handle->ClearWeak();
-                    wrapper->handle->Reset();
-                    delete wrapper->handle;
-                }
-                if (wrapper->managedHandle.IsAllocated)
-                    wrapper->managedHandle.Free();
-                delete wrapper;
-            }
-        }
+			mExternalPool->Delete(wrapped.Pointer);
+        for each (System::IntPtr p in mFunctions)
+            JavascriptFunction::ReleaseWrapper((JavascriptFunctionWrapper *)p.ToPointer());
+        ReleasePendingScripts();
         for each (WrappedMethod wrapped in mMethods->Values)
         {
             wrapped.Pointer->Reset();
@@ -207,13 +465,41 @@ JavascriptContext::~JavascriptContext()
         }
         for each (System::IntPtr p in mTypeToConstructorMapping->Values) {
             delete (void *)p;
+        }
+        for each (System::IntPtr p in mModules->Values)
+        {
+            Persistent<Module> *module = (Persistent<Module> *)p.ToPointer();
+            module->Reset();
+            delete module;
+        }
+        ClearRegExpSources();
+        ClearInternedStrings();
+        for each (System::IntPtr p in mMappedFileViews->Values)
+            delete (std::weak_ptr<BackingStore> *)p.ToPointer();
+        mDateConstructor->Reset();
+        delete mDateConstructor;
+        mDateGetTimezoneOffset->Reset();
+        delete mDateGetTimezoneOffset;
+        if (mFunctionWrapperKey != nullptr)
+        {
+            mFunctionWrapperKey->Reset();
+            delete mFunctionWrapperKey;
         }
 		delete mContext;
         mContext = nullptr;
 		delete mExternals;
+        delete mExternalPool;
         delete mFunctions;
         delete mMethods;
         delete mTypeToConstructorMapping;
+        delete mModules;
+        delete mModuleIdentifiers;
+        delete mResolvedModules;
+        delete mRegexCache;
+        delete mRegExpSources;
+        delete mInternedStrings;
+        delete mInternedStringsByUse;
+        delete mMappedFileViews;
 	}
 	if (isolate != NULL)
 		isolate->Dispose();
@@ -240,6 +526,189 @@ void JavascriptContext::SetFlags(System::String^ flags)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Throws the exception matching a Win32 error returned by MapFileIntoMemory().
+static void ThrowMapFileError(System::String^ path, DWORD error)
+{
+    System::String^ message = System::String::Format("Could not map '{0}': {1}", path, (gcnew System::ComponentModel::Win32Exception(error))->Message);
+    if (error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND)
+        throw gcnew System::IO::FileNotFoundException(message, path);
+    throw gcnew System::IO::IOException(message, HRESULT_FROM_WIN32(error));
+}
+
+JavascriptArrayBuffer^ JavascriptContext::MapFile(System::String^ path, bool readOnly)
+{
+    if (path == nullptr)
+        throw gcnew System::ArgumentNullException("path");
+
+    UnmanagedInitialisation();
+
+    pin_ptr<const wchar_t> pathPtr = PtrToStringChars(System::IO::Path::GetFullPath(path));
+    size_t length;
+    DWORD error;
+    if (readOnly)
+    {
+        HANDLE mapping = CreateFileSection(pathPtr, true, &length, &error);
+        if (error != ERROR_SUCCESS)
+            ThrowMapFileError(path, error);
+        if (mapping == NULL)
+            return gcnew JavascriptArrayBuffer(ArrayBuffer::NewBackingStore(nullptr, 0, BackingStore::EmptyDeleter, nullptr));
+
+        MappedFileSection *section = new MappedFileSection(mapping, length);
+        std::unique_ptr<BackingStore> store = section->NewView(&error);
+        if (!store)
+        {
+            section->Release();
+            ThrowMapFileError(path, error);
+        }
+        return gcnew JavascriptArrayBuffer(section, std::move(store));
+    }
+
+    void *view = MapFileIntoMemory(pathPtr, false, &length, &error);
+    if (error != ERROR_SUCCESS)
+        ThrowMapFileError(path, error);
+
+    if (view == nullptr)
+        return gcnew JavascriptArrayBuffer(ArrayBuffer::NewBackingStore(nullptr, 0, BackingStore::EmptyDeleter, nullptr));
+
+#ifdef V8_ENABLE_SANDBOX
+    std::unique_ptr<BackingStore> store = CopyIntoSandbox(view, length);
+    if (!store)
+        throw gcnew System::OutOfMemoryException(System::String::Format("Could not allocate {0} bytes for '{1}'", length, path));
+    return gcnew JavascriptArrayBuffer(std::move(store));
+#else
+    return gcnew JavascriptArrayBuffer(ArrayBuffer::NewBackingStore(view, length, UnmapFile, nullptr));
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Copies a code cache created by V8 into a .NET array, and deletes it.
+static cli::array<unsigned char>^ TakeCodeCache(ScriptCompiler::CachedData *cachedData)
+{
+    if (cachedData == nullptr)
+        return nullptr;
+    cli::array<unsigned char>^ codeCache = gcnew cli::array<unsigned char>(cachedData->length);
+    if (cachedData->length > 0)
+        System::Runtime::InteropServices::Marshal::Copy(System::IntPtr((void *)cachedData->data), codeCache, 0, cachedData->length);
+    delete cachedData;
+    return codeCache;
+}
+
+ScriptFile::!ScriptFile()
+{
+    if (source != System::IntPtr::Zero)
+    {
+        ((MappedScriptSource *)source.ToPointer())->Release();
+        source = System::IntPtr::Zero;
+    }
+}
+
+// Limits how many script files stay mapped just because they have been run once.
+static const int kMaxScriptFiles = 256;
+
+ScriptFile^
+JavascriptContext::GetScriptFile(System::String^ path)
+{
+    System::String^ fullPath = System::IO::Path::GetFullPath(path);
+    System::IO::FileInfo^ info = gcnew System::IO::FileInfo(fullPath);
+    if (!info->Exists)
+        throw gcnew System::IO::FileNotFoundException(System::String::Format("Could not find '{0}'", path), path);
+
+    msclr::lock l(sScriptFiles);
+    ScriptFile^ file;
+    if (sScriptFiles->TryGetValue(fullPath, file) && file->lastWriteTimeUtc == info->LastWriteTimeUtc && file->length == info->Length)
+        return file;
+
+    // A mapping that has been replaced is released by its finalizer, because other threads may
+    // still be creating strings over it.
+    pin_ptr<const wchar_t> pathPtr = PtrToStringChars(fullPath);
+    size_t length;
+    DWORD error;
+    void *view = MapFileIntoMemory(pathPtr, true, &length, &error);
+    if (error != ERROR_SUCCESS)
+        ThrowMapFileError(path, error);
+
+    file = gcnew ScriptFile();
+    file->path = fullPath;
+    file->lastWriteTimeUtc = info->LastWriteTimeUtc;
+    file->length = info->Length;
+    file->source = System::IntPtr(new MappedScriptSource(view, length));
+    if (sScriptFiles->Count >= kMaxScriptFiles)
+        sScriptFiles->Clear();
+    sScriptFiles[fullPath] = file;
+    return file;
+}
+
+Local<UnboundScript>
+JavascriptContext::CompileScriptFile(ScriptFile^ file)
+{
+    MappedScriptSource *mapped = (MappedScriptSource *)file->source.ToPointer();
+    MaybeLocal<String> maybeSource;
+    if (mapped->textLength() == 0)
+        maybeSource = String::Empty(isolate);
+    else if (mapped->encoding() == kAsciiScript)
+        maybeSource = String::NewExternalOneByte(isolate, new MappedScriptResource<String::ExternalOneByteStringResource, char>(mapped));
+    else if (mapped->encoding() == kUtf16Script)
+        maybeSource = String::NewExternalTwoByte(isolate, new MappedScriptResource<String::ExternalStringResource, uint16_t>(mapped));
+    else if (mapped->textLength() <= System::Int32::MaxValue)
+        maybeSource = String::NewFromUtf8(isolate, mapped->text(), NewStringType::kNormal, (int)mapped->textLength());
+    // The source strings now hold their own reference to the mapping.
+    System::GC::KeepAlive(file);
+
+    Local<String> source;
+    if (!maybeSource.ToLocal(&source))
+        throw gcnew System::IO::IOException(System::String::Format("'{0}' is too large for a JavaScript string", file->path));
+
+    Local<String> resourceName = JavascriptInterop::ConvertStringToV8(file->path);
+    ScriptOrigin origin(resourceName);
+
+    // Another context may replace the cache while we are using it.
+    cli::array<unsigned char>^ codeCache = file->codeCache;
+    pin_ptr<unsigned char> codeCachePtr = nullptr;
+    ScriptCompiler::CachedData *cachedData = nullptr;
+    if (codeCache != nullptr && codeCache->Length > 0)
+    {
+        codeCachePtr = &codeCache[0];
+        cachedData = new ScriptCompiler::CachedData(codeCachePtr, codeCache->Length);
+    }
+
+    // Takes ownership of cachedData.
+    ScriptCompiler::Source scriptSource(source, origin, cachedData);
+    TryCatch tryCatch(isolate);
+    MaybeLocal<UnboundScript> script = ScriptCompiler::CompileUnboundScript(isolate, &scriptSource,
+        cachedData != nullptr ? ScriptCompiler::kConsumeCodeCache : ScriptCompiler::kNoCompileOptions);
+    if (script.IsEmpty())
+        throw gcnew JavascriptException(tryCatch);
+
+    // V8 rejects caches made by another V8 version or with other flags.  Dropping it lets
+    // StoreCodeCache() replace it with one that works.
+    if (cachedData != nullptr && scriptSource.GetCachedData()->rejected)
+    {
+        msclr::lock l(file);
+        if (file->codeCache == codeCache)
+            file->codeCache = nullptr;
+    }
+
+    return script.ToLocalChecked();
+}
+
+void
+JavascriptContext::StoreCodeCache(ScriptFile^ file, Local<UnboundScript> script)
+{
+    if (file->codeCache != nullptr)
+        return;
+
+    cli::array<unsigned char>^ codeCache = TakeCodeCache(ScriptCompiler::CreateCodeCache(script));
+    if (codeCache == nullptr)
+        return;
+
+    msclr::lock l(file);
+    if (file->codeCache == nullptr)
+        file->codeCache = codeCache;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void JavascriptContext::TerminateExecution()
 {
 	// For backwards compatibility.
@@ -291,7 +760,7 @@ JavascriptContext::SetParameter(System::String^ iName, System::Object^ iObject,
 		}
 	}
 
-    v8::Local<v8::String> key = ToV8String(isolate, iName);
+    v8::Local<v8::String> key = ToV8String(iName);
 	Local<Context>::New(isolate, *mContext)->Global()->Set(isolate->GetCurrentContext(), key, value).ToChecked();
 }
 
@@ -309,7 +778,7 @@ void JavascriptContext::SetConstructor(System::String^ name, System::Type^ assoc
     HandleScope handleScope(isolate);
     Local<Context> context = isolate->GetCurrentContext();
 
-    Local<String> className = ToV8String(isolate, name);
+    Local<String> className = ToV8String(name);
     Local<FunctionTemplate> functionTemplate = JavascriptInterop::GetFunctionTemplateFromSystemDelegate(constructor);
     functionTemplate->SetClassName(className);
     auto instanceTemplate = functionTemplate->InstanceTemplate();
@@ -325,14 +794,12 @@ JavascriptContext::GetParameter(System::String^ iName)
 {
 	if (iName == nullptr)
 		throw gcnew System::ArgumentNullException("iName");
-	pin_ptr<const wchar_t> namePtr = PtrToStringChars(iName);
-	wchar_t* name = (wchar_t*)namePtr;
 	JavascriptScope scope(this);
 	v8::Isolate *isolate = JavascriptContext::GetCurrentIsolate();
 	HandleScope handleScope(isolate);
 	
     auto context = Local<Context>::New(isolate, *mContext);
-	Local<Value> value = context->Global()->Get(context, String::NewFromTwoByte(isolate, (uint16_t*)name, v8::NewStringType::kNormal).ToLocalChecked()).ToLocalChecked();
+	Local<Value> value = context->Global()->Get(context, ToV8String(iName)).ToLocalChecked();
 	return JavascriptInterop::ConvertFromV8(value);
 }
 
@@ -345,24 +812,13 @@ JavascriptContext::Run(System::String^ iScript)
 		throw gcnew System::ArgumentNullException("iScript");
 	if (terminateRuns)
 		throw gcnew JavascriptException(L"Execution terminated");
-	pin_ptr<const wchar_t> scriptPtr = PtrToStringChars(iScript);
-	wchar_t* script = (wchar_t*)scriptPtr;
 	JavascriptScope scope(this);
 	//SetStackLimit();
 	HandleScope handleScope(isolate);
-	MaybeLocal<Value> ret;
 	
-	Local<Script> compiledScript = CompileScript(isolate, script);
-
-	{
-		TryCatch tryCatch(isolate);
-		ret = (*compiledScript)->Run(this->GetCurrentIsolate()->GetCurrentContext());
+	Local<Script> compiledScript = CompileScript(isolate, JavascriptInterop::ConvertStringToV8(iScript));
 
-		if (ret.IsEmpty())
-			throw gcnew JavascriptException(tryCatch);
-	}
-	
-	return JavascriptInterop::ConvertFromV8(ret.ToLocalChecked());
+	return RunCompiledScript(compiledScript);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -376,115 +832,694 @@ JavascriptContext::Run(System::String^ iScript, System::String^ iScriptResourceN
 		throw gcnew System::ArgumentNullException("iScriptResourceName");
 	if (terminateRuns)
 		throw gcnew JavascriptException(L"Execution terminated");
-	pin_ptr<const wchar_t> scriptPtr = PtrToStringChars(iScript);
-	wchar_t* script = (wchar_t*)scriptPtr;
 	pin_ptr<const wchar_t> scriptResourceNamePtr = PtrToStringChars(iScriptResourceName);
 	wchar_t* scriptResourceName = (wchar_t*)scriptResourceNamePtr;
 	JavascriptScope scope(this);
 	//SetStackLimit();
 	HandleScope handleScope(isolate);
-	MaybeLocal<Value> ret;	
 
-	Local<Script> compiledScript = CompileScript(isolate, script, scriptResourceName);
-	
-	{
-		TryCatch tryCatch(isolate);
-		ret = (*compiledScript)->Run(this->GetCurrentIsolate()->GetCurrentContext());
+	Local<Script> compiledScript = CompileScript(isolate, JavascriptInterop::ConvertStringToV8(iScript), scriptResourceName);
 
-		if (ret.IsEmpty())
-			throw gcnew JavascriptException(tryCatch);
-	}
-	
-	return JavascriptInterop::ConvertFromV8(ret.ToLocalChecked());
+	return RunCompiledScript(compiledScript);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-static System::String^ v8StringToString(v8::Local<v8::String> handle) {
-    if (handle.IsEmpty()) {
-        return nullptr;
-    }
-    return (System::String^)JavascriptInterop::ConvertFromV8(handle);
+System::Object^
+JavascriptContext::RunFile(System::String^ path)
+{
+	if (path == nullptr)
+		throw gcnew System::ArgumentNullException("path");
+	if (terminateRuns)
+		throw gcnew JavascriptException(L"Execution terminated");
+	ScriptFile^ file = GetScriptFile(path);
+	JavascriptScope scope(this);
+	HandleScope handleScope(isolate);
+
+	Local<UnboundScript> script = CompileScriptFile(file);
+	System::Object^ result = RunCompiledScript(script->BindToCurrentContext());
+
+	// Waiting until the script has run means that the functions it called are in the cache too.
+	StoreCodeCache(file, script);
+	return result;
 }
 
-System::Collections::Generic::List<JavascriptStackFrame^>^
-JavascriptContext::GetCurrentStack(int maxDepth)
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+JavascriptScript^
+JavascriptContext::CompileFile(System::String^ path)
 {
-    auto stack = gcnew System::Collections::Generic::List<JavascriptStackFrame^>();
-    v8::Local<v8::StackTrace> stackTrace = v8::StackTrace::CurrentStackTrace(
-        this->GetCurrentIsolate(), maxDepth, v8::StackTrace::kScriptName
-    );
+	if (path == nullptr)
+		throw gcnew System::ArgumentNullException("path");
+	ScriptFile^ file = GetScriptFile(path);
+	JavascriptScope scope(this);
+	HandleScope handleScope(isolate);
 
-    for (int i = 0; i < stackTrace->GetFrameCount(); ++i) {
-        v8::Local<v8::StackFrame> frame = stackTrace->GetFrame(this->GetCurrentIsolate(), i);
-        JavascriptStackFrame^ managedFrame = gcnew JavascriptStackFrame();
-        managedFrame->LineNumber = frame->GetLineNumber();
-        managedFrame->Column = frame->GetColumn();
-        managedFrame->FunctionName = v8StringToString(frame->GetFunctionName());
-        managedFrame->ScriptName = v8StringToString(frame->GetScriptName());
-        managedFrame->ScriptNameOrSourceURL = v8StringToString(frame->GetScriptNameOrSourceURL());
-        managedFrame->IsEval = frame->IsEval();
-        managedFrame->IsConstructor = frame->IsConstructor();
-        managedFrame->IsWasm = frame->IsWasm();
-        stack->Add(managedFrame);
-    }
-    return stack;
+	Local<UnboundScript> script = CompileScriptFile(file);
+	StoreCodeCache(file, script);
+	return gcnew JavascriptScript(script, this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-//void
-//JavascriptContext::SetStackLimit()
-//{
-//    // This stack limit needs to be set for each Run because the
-//    // stack of the caller could be in completely different spots (e.g.
-//    // different threads), or have moved up/down because calls/returns.
-//	v8::ResourceConstraints rc;
-//
-//    // Copied form v8/test/cctest/test-api.cc
-//    uint32_t size = 500000;
-//    uint32_t* limit = &size - (size / sizeof(size));
-//    // If the size is very large and the stack is very near the bottom of
-//    // memory then the calculation above may wrap around and give an address
-//    // that is above the (downwards-growing) stack.  In that case we return
-//    // a very low address.
-//    if (limit > &size)
-//        limit = reinterpret_cast<uint32_t*>(sizeof(size));
-//    
-//    int mos = rc.max_old_space_size();
-//    
-//    rc.set_stack_limit((uint32_t *)(limit));
-//    rc.set_max_old_space_size(1700);
-//	v8::SetResourceConstraints(isolate, &rc);
-//}
+// Feeds V8's background parser from a .NET Stream (as UTF-8) or TextReader (as UTF-16).  V8 needs
+// the complete source once more after parsing, so everything read is kept as well.
+class ManagedSourceStream: public ScriptCompiler::ExternalSourceStream
+{
+public:
+	ManagedSourceStream(System::IO::Stream^ stream) :
+		mStream(stream), mBytes(gcnew System::IO::MemoryStream()), mByteBuffer(gcnew cli::array<unsigned char>(kChunkSize)) {}
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
+	ManagedSourceStream(System::IO::TextReader^ reader) :
+		mReader(reader), mText(gcnew System::Text::StringBuilder()), mCharBuffer(gcnew cli::array<wchar_t>(kChunkSize / 2)) {}
 
-JavascriptContext^
-JavascriptContext::GetCurrent()
+	// Called by V8 on the parsing thread until it returns 0.
+	size_t GetMoreData(const uint8_t **src) override
+	{
+		*src = nullptr;
+		try
+		{
+			// V8 takes ownership of the chunks.
+			uint8_t *chunk;
+			int length;
+			if (static_cast<System::IO::Stream^>(mStream) != nullptr)
+			{
+				cli::array<unsigned char>^ buffer = mByteBuffer;
+				length = mStream->Read(buffer, 0, buffer->Length);
+				if (length <= 0)
+					return 0;
+				mBytes->Write(buffer, 0, length);
+				pin_ptr<unsigned char> bufferPtr = &buffer[0];
+				chunk = new uint8_t[length];
+				memcpy(chunk, bufferPtr, length);
+			}
+			else
+			{
+				cli::array<wchar_t>^ buffer = mCharBuffer;
+				int read = mReader->Read(buffer, 0, buffer->Length);
+				if (read <= 0)
+					return 0;
+				mText->Append(buffer, 0, read);
+				length = read * 2;
+				pin_ptr<wchar_t> bufferPtr = &buffer[0];
+				chunk = new uint8_t[length];
+				memcpy(chunk, bufferPtr, length);
+			}
+			*src = chunk;
+			return length;
+		}
+		catch (System::Exception^ e)
+		{
+			// Exceptions can't pass through V8, so we end the script here and rethrow once it is done.
+			mError = System::Runtime::ExceptionServices::ExceptionDispatchInfo::Capture(e);
+			return 0;
+		}
+	}
+
+	void ThrowIfFailed()
+	{
+		if (static_cast<System::Runtime::ExceptionServices::ExceptionDispatchInfo^>(mError) != nullptr)
+			mError->Throw();
+	}
+
+	Local<String> GetSource(Isolate *isolate)
+	{
+		if (static_cast<System::Text::StringBuilder^>(mText) != nullptr)
+			return JavascriptInterop::ConvertStringToV8(mText->ToString());
+
+		if (mBytes->Length == 0)
+			return String::Empty(isolate);
+		if (mBytes->Length > System::Int32::MaxValue)
+			throw gcnew System::IO::IOException("The script is too large for a JavaScript string");
+		cli::array<unsigned char>^ bytes = mBytes->GetBuffer();
+		int length = (int)mBytes->Length;
+
+		// V8's streaming parser skips a byte order mark, so the source must not contain it either,
+		// or positions recorded for lazy functions would be off by one.
+		int start = 0;
+		if (length >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF)
+			start = 3;
+		if (start == length)
+			return String::Empty(isolate);
+
+		pin_ptr<unsigned char> bytesPtr = &bytes[start];
+		Local<String> source;
+		if (!String::NewFromUtf8(isolate, (const char *)bytesPtr, NewStringType::kNormal, length - start).ToLocal(&source))
+			throw gcnew System::IO::IOException("The script is too large for a JavaScript string");
+		return source;
+	}
+
+private:
+	static const int kChunkSize = 64 * 1024;
+
+	gcroot<System::IO::Stream^> mStream;
+	gcroot<System::IO::MemoryStream^> mBytes;
+	gcroot<cli::array<unsigned char>^> mByteBuffer;
+	gcroot<System::IO::TextReader^> mReader;
+	gcroot<System::Text::StringBuilder^> mText;
+	gcroot<cli::array<wchar_t>^> mCharBuffer;
+	gcroot<System::Runtime::ExceptionServices::ExceptionDispatchInfo^> mError;
+};
+
+// State of one CompileAsync() call, passed to the worker thread.
+ref class StreamingCompilation
 {
-	return sCurrentContext;
+public:
+	JavascriptContext^ context;
+	System::String^ resourceName;
+	ManagedSourceStream *stream;
+	ScriptCompiler::StreamedSource *source;
+	ScriptCompiler::ScriptStreamingTask *task;
+
+	JavascriptScript^ Compile()
+	{
+		try
+		{
+			// Reads and parses the whole script, without the isolate's lock.
+			task->Run();
+
+			JavascriptScope scope(context);
+			Isolate *isolate = context->GetCurrentIsolate();
+			HandleScope handleScope(isolate);
+			try
+			{
+				stream->ThrowIfFailed();
+
+				Local<String> name = JavascriptInterop::ConvertStringToV8(resourceName);
+				ScriptOrigin origin(name);
+				TryCatch tryCatch(isolate);
+				MaybeLocal<Script> script = ScriptCompiler::Compile(isolate->GetCurrentContext(), source, stream->GetSource(isolate), origin);
+				if (script.IsEmpty())
+					throw gcnew JavascriptException(tryCatch);
+
+				return gcnew JavascriptScript(script.ToLocalChecked()->GetUnboundScript(), context);
+			}
+			finally
+			{
+				// Also deletes the stream.
+				delete task;
+				delete source;
+			}
+		}
+		finally
+		{
+			context->mPendingCompilations->Signal();
+		}
+	}
+};
+
+static System::Threading::Tasks::Task<JavascriptScript^>^
+StartStreamingCompilation(JavascriptContext^ context, ManagedSourceStream *stream, ScriptCompiler::StreamedSource::Encoding encoding, System::String^ resourceName)
+{
+	StreamingCompilation^ compilation = gcnew StreamingCompilation();
+	compilation->context = context;
+	compilation->resourceName = resourceName;
+	compilation->stream = stream;
+	compilation->source = new ScriptCompiler::StreamedSource(std::unique_ptr<ScriptCompiler::ExternalSourceStream>(stream), encoding);
+	{
+		JavascriptScope scope(context);
+		HandleScope handleScope(context->GetCurrentIsolate());
+		compilation->task = ScriptCompiler::StartStreaming(context->GetCurrentIsolate(), compilation->source);
+	}
+
+	context->mPendingCompilations->AddCount();
+	return System::Threading::Tasks::Task<JavascriptScript^>::Run(gcnew System::Func<JavascriptScript^>(compilation, &StreamingCompilation::Compile));
 }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
+System::Threading::Tasks::Task<JavascriptScript^>^
+JavascriptContext::CompileAsync(System::IO::TextReader^ reader, System::String^ resourceName)
+{
+	if (reader == nullptr)
+		throw gcnew System::ArgumentNullException("reader");
+	if (resourceName == nullptr)
+		throw gcnew System::ArgumentNullException("resourceName");
+	return StartStreamingCompilation(this, new ManagedSourceStream(reader), ScriptCompiler::StreamedSource::TWO_BYTE, resourceName);
+}
 
-v8::Isolate *
-JavascriptContext::GetCurrentIsolate()
+System::Threading::Tasks::Task<JavascriptScript^>^
+JavascriptContext::CompileAsync(System::IO::Stream^ stream, System::String^ resourceName)
 {
-	return sCurrentContext->isolate;
+	if (stream == nullptr)
+		throw gcnew System::ArgumentNullException("stream");
+	if (resourceName == nullptr)
+		throw gcnew System::ArgumentNullException("resourceName");
+	return StartStreamingCompilation(this, new ManagedSourceStream(stream), ScriptCompiler::StreamedSource::UTF8, resourceName);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Local<v8::Object> JavascriptContext::GetGlobal()
+System::Object^
+JavascriptContext::RunCompiledScript(Local<Script> script)
 {
-	return mContext->Get(this->GetCurrentIsolate())->Global();
+	if (terminateRuns)
+		throw gcnew JavascriptException(L"Execution terminated");
+	MaybeLocal<Value> ret;
+
+	{
+		TryCatch tryCatch(isolate);
+		ret = script->Run(isolate->GetCurrentContext());
+
+		if (ret.IsEmpty())
+			throw gcnew JavascriptException(tryCatch);
+	}
+
+	return JavascriptInterop::ConvertFromV8(ret.ToLocalChecked());
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-v8::Locker *
-JavascriptContext::Enter([System::Runtime::InteropServices::Out] JavascriptContext^% old_context)
+// Turns a JavaScript exception that was never thrown in a TryCatch (e.g. the reason a promise was
+// rejected) into a JavascriptException.
+static JavascriptException^ ToJavascriptException(Isolate *isolate, Local<Value> exception)
+{
+	TryCatch tryCatch(isolate);
+	isolate->ThrowException(exception);
+	return gcnew JavascriptException(tryCatch);
+}
+
+// Passed to Module::InstantiateModule().  LoadModule() has loaded every dependency already.
+static MaybeLocal<Module> ResolveModuleCallback(Local<Context> context, Local<String> specifier, Local<FixedArray> import_attributes, Local<Module> referrer)
+{
+	Local<Module> module = JavascriptContext::GetCurrent()->GetModule(specifier, referrer);
+	if (module.IsEmpty())
+		context->GetIsolate()->ThrowException(Exception::Error(String::NewFromUtf8Literal(context->GetIsolate(), "Module not loaded")));
+	return module;
+}
+
+// Fulfills the promise returned by import() with the module namespace in the function's data.
+static void ReturnModuleNamespace(const FunctionCallbackInfo<Value>& info)
+{
+	info.GetReturnValue().Set(info.Data());
+}
+
+// Called by V8 for import() in scripts and modules.
+static MaybeLocal<Promise> ImportModuleDynamically(Local<Context> context, Local<Data> host_defined_options, Local<Value> resource_name, Local<String> specifier, Local<FixedArray> import_attributes)
+{
+	Isolate *isolate = context->GetIsolate();
+	EscapableHandleScope handleScope(isolate);
+	Local<Promise::Resolver> resolver = Promise::Resolver::New(context).ToLocalChecked();
+	try
+	{
+		System::String^ referrer = resource_name->IsString() ? JavascriptInterop::ConvertStringFromV8(resource_name.As<String>()) : nullptr;
+		Local<Module> module = JavascriptContext::GetCurrent()->InstantiateModule(JavascriptInterop::ConvertStringFromV8(specifier), referrer);
+
+		TryCatch tryCatch(isolate);
+		Local<Value> evaluation;
+		if (!module->Evaluate(context).ToLocal(&evaluation))
+			throw gcnew JavascriptException(tryCatch);
+		Local<Function> returnNamespace = Function::New(context, ReturnModuleNamespace, module->GetModuleNamespace()).ToLocalChecked();
+		Local<Promise> promise;
+		if (!evaluation.As<Promise>()->Then(context, returnNamespace).ToLocal(&promise))
+			throw gcnew JavascriptException(tryCatch);
+		return handleScope.Escape(promise);
+	}
+	catch (System::Exception^ exception)
+	{
+		resolver->Reject(context, JavascriptInterop::ConvertToV8(exception)).Check();
+	}
+	return handleScope.Escape(resolver->GetPromise());
+}
+
+System::Object^
+JavascriptContext::RunModule(System::String^ specifier)
+{
+	if (specifier == nullptr)
+		throw gcnew System::ArgumentNullException("specifier");
+	if (mModuleResolver == nullptr)
+		throw gcnew System::InvalidOperationException("Set ModuleResolver before running modules");
+	if (terminateRuns)
+		throw gcnew JavascriptException(L"Execution terminated");
+	JavascriptScope scope(this);
+	HandleScope handleScope(isolate);
+
+	Local<Module> module = InstantiateModule(specifier, nullptr);
+	Local<Value> evaluation;
+	{
+		TryCatch tryCatch(isolate);
+		if (!module->Evaluate(isolate->GetCurrentContext()).ToLocal(&evaluation))
+			throw gcnew JavascriptException(tryCatch);
+	}
+
+	// Evaluation returns a promise, because of top-level await.  Nothing else will run the
+	// microtasks that settle it.
+	isolate->PerformMicrotaskCheckpoint();
+	Local<Promise> promise = evaluation.As<Promise>();
+	if (promise->State() == Promise::kRejected)
+		throw ToJavascriptException(isolate, promise->Result());
+	if (promise->State() == Promise::kPending)
+		throw gcnew JavascriptException(L"The module is still waiting for a top-level await");
+
+	return JavascriptInterop::ConvertFromV8(module->GetModuleNamespace());
+}
+
+Local<Module>
+JavascriptContext::InstantiateModule(System::String^ specifier, System::String^ referrer)
+{
+	if (mModuleResolver == nullptr)
+		throw gcnew System::InvalidOperationException("Set ModuleResolver before importing modules");
+
+	Local<Module> module = LoadModule(ResolveModule(specifier, referrer));
+	if (module->GetStatus() == Module::kUninstantiated)
+	{
+		TryCatch tryCatch(isolate);
+		if (module->InstantiateModule(isolate->GetCurrentContext(), ResolveModuleCallback).IsNothing())
+			throw gcnew JavascriptException(tryCatch);
+	}
+	return module;
+}
+
+Local<Module>
+JavascriptContext::GetModule(Local<String> specifier, Local<Module> referrer)
+{
+	System::String^ referrerIdentifier;
+	System::String^ identifier;
+	System::IntPtr module;
+	if (!mModuleIdentifiers->TryGetValue(referrer->ScriptId(), referrerIdentifier)
+		|| !mResolvedModules->TryGetValue(System::ValueTuple<System::String^, System::String^>(referrerIdentifier, JavascriptInterop::ConvertStringFromV8(specifier)), identifier)
+		|| !mModules->TryGetValue(identifier, module))
+		return Local<Module>();
+	return ((Persistent<Module> *)module.ToPointer())->Get(isolate);
+}
+
+System::String^
+JavascriptContext::ResolveModule(System::String^ specifier, System::String^ referrer)
+{
+	System::String^ identifier = mModuleResolver->Resolve(specifier, referrer);
+	if (identifier == nullptr)
+		throw gcnew System::InvalidOperationException(System::String::Format("Could not resolve module '{0}'", specifier));
+	return identifier;
+}
+
+Local<Module>
+JavascriptContext::LoadModule(System::String^ identifier)
+{
+	// If any module fails to load, all the modules loaded along with it go again, including ones
+	// that loaded fine but import a module that didn't.  Otherwise they would stay in mModules
+	// without all their dependencies, and couldn't ever be instantiated.
+	System::Collections::Generic::List<System::String^>^ loaded = gcnew System::Collections::Generic::List<System::String^>();
+	try
+	{
+		return LoadModule(identifier, loaded);
+	}
+	catch (System::Exception^)
+	{
+		UnloadModules(loaded);
+		throw;
+	}
+}
+
+Local<Module>
+JavascriptContext::LoadModule(System::String^ identifier, System::Collections::Generic::List<System::String^>^ loaded)
+{
+	System::IntPtr existing;
+	if (mModules->TryGetValue(identifier, existing))
+		return ((Persistent<Module> *)existing.ToPointer())->Get(isolate);
+
+	System::String^ source = mModuleResolver->Load(identifier);
+	if (source == nullptr)
+		throw gcnew System::InvalidOperationException(System::String::Format("Could not load module '{0}'", identifier));
+	Local<Module> module = CompileModule(identifier, source);
+	// Added before the dependencies, so that import cycles end here.
+	mModules->Add(identifier, System::IntPtr(new Persistent<Module>(isolate, module)));
+	mModuleIdentifiers[module->ScriptId()] = identifier;
+	loaded->Add(identifier);
+
+	// Loading the dependencies now means ResolveModuleCallback() only has to look them up.
+	Local<Context> context = isolate->GetCurrentContext();
+	Local<FixedArray> requests = module->GetModuleRequests();
+	for (int i = 0; i < requests->Length(); i++)
+	{
+		System::String^ specifier = JavascriptInterop::ConvertStringFromV8(requests->Get(context, i).As<ModuleRequest>()->GetSpecifier());
+		System::String^ dependency = ResolveModule(specifier, identifier);
+		LoadModule(dependency, loaded);
+		mResolvedModules[System::ValueTuple<System::String^, System::String^>(identifier, specifier)] = dependency;
+	}
+	return module;
+}
+
+void
+JavascriptContext::UnloadModules(System::Collections::Generic::List<System::String^>^ identifiers)
+{
+	for each (System::String^ identifier in identifiers)
+	{
+		Persistent<Module> *module = (Persistent<Module> *)mModules[identifier].ToPointer();
+		mModuleIdentifiers->Remove(module->Get(isolate)->ScriptId());
+		mModules->Remove(identifier);
+		module->Reset();
+		delete module;
+	}
+
+	System::Collections::Generic::List<System::ValueTuple<System::String^, System::String^>>^ imports = gcnew System::Collections::Generic::List<System::ValueTuple<System::String^, System::String^>>();
+	for each (System::ValueTuple<System::String^, System::String^> key in mResolvedModules->Keys)
+	{
+		if (identifiers->Contains(key.Item1))
+			imports->Add(key);
+	}
+	for each (System::ValueTuple<System::String^, System::String^> key in imports)
+		mResolvedModules->Remove(key);
+}
+
+// Limits how many modules' code caches are kept for the life of the process.
+static const int kMaxCachedModuleCodes = 256;
+
+Local<Module>
+JavascriptContext::CompileModule(System::String^ identifier, System::String^ source)
+{
+	Local<String> sourceString = JavascriptInterop::ConvertStringToV8(source);
+	ScriptOrigin origin(JavascriptInterop::ConvertStringToV8(identifier), 0, 0, false, -1, Local<Value>(), false, false, true);
+
+	// Other contexts may have compiled the same module already.
+	CachedModuleCode^ cached;
+	{
+		msclr::lock l(sModuleCodeCaches);
+		if (!sModuleCodeCaches->TryGetValue(identifier, cached) || !cached->source->Equals(source))
+			cached = nullptr;
+	}
+	pin_ptr<unsigned char> codeCachePtr = nullptr;
+	ScriptCompiler::CachedData *cachedData = nullptr;
+	if (cached != nullptr && cached->codeCache->Length > 0)
+	{
+		codeCachePtr = &cached->codeCache[0];
+		cachedData = new ScriptCompiler::CachedData(codeCachePtr, cached->codeCache->Length);
+	}
+
+	// Takes ownership of cachedData.
+	ScriptCompiler::Source moduleSource(sourceString, origin, cachedData);
+	TryCatch tryCatch(isolate);
+	Local<Module> module;
+	if (!ScriptCompiler::CompileModule(isolate, &moduleSource, cachedData != nullptr ? ScriptCompiler::kConsumeCodeCache : ScriptCompiler::kNoCompileOptions).ToLocal(&module))
+		throw gcnew JavascriptException(tryCatch);
+
+	if (cachedData == nullptr || moduleSource.GetCachedData()->rejected)
+	{
+		cli::array<unsigned char>^ codeCache = TakeCodeCache(ScriptCompiler::CreateCodeCache(module->GetUnboundModuleScript()));
+		if (codeCache != nullptr)
+		{
+			CachedModuleCode^ entry = gcnew CachedModuleCode();
+			entry->source = source;
+			entry->codeCache = codeCache;
+			msclr::lock l(sModuleCodeCaches);
+			if (sModuleCodeCaches->Count >= kMaxCachedModuleCodes)
+				sModuleCodeCaches->Clear();
+			sModuleCodeCaches[identifier] = entry;
+		}
+	}
+	return module;
+}
+
+JavascriptFunction^
+JavascriptContext::CompileFunction(System::String^ body, ... cli::array<System::String^>^ parameterNames)
+{
+	if (body == nullptr)
+		throw gcnew System::ArgumentNullException("body");
+	if (parameterNames == nullptr)
+		throw gcnew System::ArgumentNullException("parameterNames");
+	JavascriptScope scope(this);
+	HandleScope handleScope(isolate);
+
+	LocalVector<String> parameters(isolate);
+	parameters.reserve(parameterNames->Length);
+	for each (System::String^ name in parameterNames)
+	{
+		if (name == nullptr)
+			throw gcnew System::ArgumentException("Parameter names must not be null", "parameterNames");
+		parameters.push_back(GetInternedString(name));
+	}
+
+	ScriptCompiler::Source source(JavascriptInterop::ConvertStringToV8(body));
+	TryCatch tryCatch(isolate);
+	Local<Function> function;
+	if (!ScriptCompiler::CompileFunction(isolate->GetCurrentContext(), &source, parameters.size(), parameters.data()).ToLocal(&function))
+		throw gcnew JavascriptException(tryCatch);
+
+	return safe_cast<JavascriptFunction^>(JavascriptInterop::ConvertFromV8(function));
+}
+
+// Limits how many compiled WebAssembly modules are kept for the life of the process.
+static const int kMaxCachedWasmModules = 64;
+
+JavascriptWasmModule^
+JavascriptContext::CompileWasmModule(cli::array<unsigned char>^ wireBytes)
+{
+	if (wireBytes == nullptr)
+		throw gcnew System::ArgumentNullException("wireBytes");
+
+	System::String^ hash = System::Convert::ToHexString(System::Security::Cryptography::SHA256::HashData(wireBytes));
+	JavascriptWasmModule^ module;
+	{
+		msclr::lock l(sWasmModules);
+		if (sWasmModules->TryGetValue(hash, module))
+			return module->Copy();
+	}
+
+	{
+		JavascriptScope scope(this);
+		HandleScope handleScope(isolate);
+		pin_ptr<unsigned char> wireBytesPtr = nullptr;
+		if (wireBytes->Length > 0)
+			wireBytesPtr = &wireBytes[0];
+		const uint8_t *data = wireBytesPtr;
+		TryCatch tryCatch(isolate);
+		Local<WasmModuleObject> compiled;
+		if (!WasmModuleObject::Compile(isolate, MemorySpan<const uint8_t>(data, wireBytes->Length)).ToLocal(&compiled))
+			throw gcnew JavascriptException(tryCatch);
+		module = gcnew JavascriptWasmModule(compiled->GetCompiledModule());
+	}
+
+	// Another thread may have compiled the same bytes in the meantime.
+	msclr::lock l(sWasmModules);
+	JavascriptWasmModule^ existing;
+	if (sWasmModules->TryGetValue(hash, existing))
+	{
+		delete module;
+		return existing->Copy();
+	}
+	if (sWasmModules->Count >= kMaxCachedWasmModules)
+	{
+		// Modules already handed out keep their own reference to the native module.
+		for each (JavascriptWasmModule^ evicted in sWasmModules->Values)
+			delete evicted;
+		sWasmModules->Clear();
+	}
+	sWasmModules->Add(hash, module);
+	return module->Copy();
+}
+
+JavascriptObjectScope^
+JavascriptContext::BeginScope()
+{
+	mObjectScope = gcnew JavascriptObjectScope(this, mObjectScope);
+	return mObjectScope;
+}
+
+void
+JavascriptContext::EndScope(JavascriptObjectScope^ scope)
+{
+	// Outer scopes ended before their inner ones are dropped along with them.
+	if (mObjectScope != scope)
+		return;
+	do
+		mObjectScope = mObjectScope->Parent;
+	while (mObjectScope != nullptr && mObjectScope->IsEnded);
+}
+
+IModuleResolver^ JavascriptContext::ModuleResolver::get()
+{
+	return mModuleResolver;
+}
+
+void JavascriptContext::ModuleResolver::set(IModuleResolver^ value)
+{
+	mModuleResolver = value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static System::String^ v8StringToString(v8::Local<v8::String> handle) {
+    if (handle.IsEmpty()) {
+        return nullptr;
+    }
+    return (System::String^)JavascriptInterop::ConvertFromV8(handle);
+}
+
+System::Collections::Generic::List<JavascriptStackFrame^>^
+JavascriptContext::GetCurrentStack(int maxDepth)
+{
+    auto stack = gcnew System::Collections::Generic::List<JavascriptStackFrame^>();
+    v8::Local<v8::StackTrace> stackTrace = v8::StackTrace::CurrentStackTrace(
+        this->GetCurrentIsolate(), maxDepth, v8::StackTrace::kScriptName
+    );
+
+    for (int i = 0; i < stackTrace->GetFrameCount(); ++i) {
+        v8::Local<v8::StackFrame> frame = stackTrace->GetFrame(this->GetCurrentIsolate(), i);
+        JavascriptStackFrame^ managedFrame = gcnew JavascriptStackFrame();
+        managedFrame->LineNumber = frame->GetLineNumber();
+        managedFrame->Column = frame->GetColumn();
+        managedFrame->FunctionName = v8StringToString(frame->GetFunctionName());
+        managedFrame->ScriptName = v8StringToString(frame->GetScriptName());
+        managedFrame->ScriptNameOrSourceURL = v8StringToString(frame->GetScriptNameOrSourceURL());
+        managedFrame->IsEval = frame->IsEval();
+        managedFrame->IsConstructor = frame->IsConstructor();
+        managedFrame->IsWasm = frame->IsWasm();
+        stack->Add(managedFrame);
+    }
+    return stack;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//void
+//JavascriptContext::SetStackLimit()
+//{
+//    // This stack limit needs to be set for each Run because the
+//    // stack of the caller could be in completely different spots (e.g.
+//    // different threads), or have moved up/down because calls/returns.
+//	v8::ResourceConstraints rc;
+//
+//    // Copied form v8/test/cctest/test-api.cc
+//    uint32_t size = 500000;
+//    uint32_t* limit = &size - (size / sizeof(size));
+//    // If the size is very large and the stack is very near the bottom of
+//    // memory then the calculation above may wrap around and give an address
+//    // that is above the (downwards-growing) stack.  In that case we return
+//    // a very low address.
+//    if (limit > &size)
+//        limit = reinterpret_cast<uint32_t*>(sizeof(size));
+//    
+//    int mos = rc.max_old_space_size();
+//    
+//    rc.set_stack_limit((uint32_t *)(limit));
+//    rc.set_max_old_space_size(1700);
+//	v8::SetResourceConstraints(isolate, &rc);
+//}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+JavascriptContext^
+JavascriptContext::GetCurrent()
+{
+	return sCurrentContext;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+v8::Isolate *
+JavascriptContext::GetCurrentIsolate()
+{
+	return sCurrentContext->isolate;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Local<v8::Object> JavascriptContext::GetGlobal()
+{
+	return mContext->Get(this->GetCurrentIsolate())->Global();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+v8::Locker *
+JavascriptContext::Enter([System::Runtime::InteropServices::Out] JavascriptContext^% old_context)
 {
 	v8::Locker *locker = new v8::Locker(isolate);
 	isolate->Enter();
@@ -492,6 +1527,10 @@ JavascriptContext::Enter([System::Runtime::InteropServices::Out] JavascriptConte
 	sCurrentContext = this;
 	HandleScope scope(isolate);
 	Local<Context>::New(isolate, *mContext)->Enter();
+	if (!mPendingReleases->IsEmpty)
+		ReleasePendingFunctions();
+	if (!mPendingScriptReleases->IsEmpty)
+		ReleasePendingScripts();
 	return locker;
 }
 
@@ -511,13 +1550,178 @@ JavascriptContext::Exit(v8::Locker *locker, JavascriptContext^ old_context)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Exposed for the benefit of a regression test.
+#pragma managed(push, off)
+// Adds every node reachable from `start` through strong edges to `marked`, except the nodes in
+// `live`.  Edges from roots (synthetic nodes) to the objects in `skipped` are ignored.
+static void MarkReachable(const HeapGraphNode *start, std::unordered_set<const HeapGraphNode *> &marked, const std::unordered_set<const HeapGraphNode *> &live, const std::unordered_set<SnapshotObjectId> &skipped)
+{
+	std::vector<const HeapGraphNode *> pending;
+	marked.insert(start);
+	pending.push_back(start);
+	while (!pending.empty())
+	{
+		const HeapGraphNode *node = pending.back();
+		pending.pop_back();
+		bool isRoot = node->GetType() == HeapGraphNode::kSynthetic;
+		for (int i = 0; i < node->GetChildrenCount(); i++)
+		{
+			const HeapGraphEdge *edge = node->GetChild(i);
+			if (edge->GetType() == HeapGraphEdge::kWeak)
+				continue;
+			const HeapGraphNode *child = edge->GetToNode();
+			if (isRoot && skipped.count(child->GetId()) != 0)
+				continue;
+			if (live.count(child) == 0 && marked.insert(child).second)
+				pending.push_back(child);
+		}
+	}
+}
+
+// Finds the wrappers of .NET objects that JavaScript only reaches through functions held by
+// JavascriptFunctions.  `reachedFrom[i]` receives the indexes into `wrappers` of those reachable
+// from `functions[i]`.  Returns whether there are any.
+static bool FindWrappersReachedOnlyFromFunctions(const HeapSnapshot *snapshot, const std::vector<SnapshotObjectId> &functions, const std::vector<SnapshotObjectId> &wrappers, std::vector<std::vector<int>> &reachedFrom)
+{
+	std::unordered_set<SnapshotObjectId> functionIds(functions.begin(), functions.end());
+	std::unordered_map<SnapshotObjectId, int> wrapperIndexes;
+	for (size_t i = 0; i < wrappers.size(); i++)
+		if (wrappers[i] != HeapProfiler::kUnknownObjectId)
+			wrapperIndexes[wrappers[i]] = (int)i;
+
+	// Our handles on the functions are roots of V8's heap, but whether they should be is up to
+	// .NET, so they are left out here.
+	std::unordered_set<const HeapGraphNode *> live;
+	MarkReachable(snapshot->GetRoot(), live, std::unordered_set<const HeapGraphNode *>(), functionIds);
+
+	bool found = false;
+	reachedFrom.assign(functions.size(), std::vector<int>());
+	for (size_t i = 0; i < functions.size(); i++)
+	{
+		const HeapGraphNode *function = snapshot->GetNodeById(functions[i]);
+		if (function == nullptr || live.count(function) != 0)
+			continue;
+		std::unordered_set<const HeapGraphNode *> reached;
+		MarkReachable(function, reached, live, functionIds);
+		for (const HeapGraphNode *node : reached)
+		{
+			auto wrapper = wrapperIndexes.find(node->GetId());
+			if (wrapper == wrapperIndexes.end())
+				continue;
+			reachedFrom[i].push_back(wrapper->second);
+			found = true;
+		}
+	}
+	return found;
+}
+#pragma managed(pop)
+
+// Exposed for the benefit of regression tests, and for long-lived contexts.  Besides running a full
+// collection, this releases .NET objects that are only kept alive by a cycle through JavaScript:
+// the object holds a JavascriptFunction, whose (strongly held) function reaches the object's own
+// wrapper.  A heap snapshot tells which wrapped objects JavaScript only reaches through such
+// functions.  .NET then holds those objects weakly for one collection, with each kept alive by the
+// JavascriptFunctions that reach it, and the ones that survive are held strongly again.
 void
 JavascriptContext::Collect()
 {
-    // The method used originally here does not exist anymore and this is the best guess for a replacement.
-    // Since this isn't used in internal tests anywhere it can't be checked for validity.
-    this->isolate->MemoryPressureNotification(v8::MemoryPressureLevel::kModerate);
+    JavascriptScope scope(this);
+    System::Collections::Generic::List<System::IntPtr>^ candidates = gcnew System::Collections::Generic::List<System::IntPtr>();
+    System::Collections::Generic::List<System::Runtime::DependentHandle>^ dependencies = gcnew System::Collections::Generic::List<System::Runtime::DependentHandle>();
+    if (FindCycleCandidates(candidates, dependencies))
+    {
+        // Finalizers must not take the isolate's lock, so waiting for them here is safe.
+        System::GC::Collect();
+        System::GC::WaitForPendingFinalizers();
+        for (int i = 0; i < dependencies->Count; i++)
+            dependencies[i].Dispose();
+
+        for each (System::IntPtr p in candidates)
+        {
+            JavascriptExternal *external = (JavascriptExternal *)p.ToPointer();
+            System::Object^ object = external->GetObject();
+            if (object != nullptr)
+            {
+                external->SetObjectHandleWeak(false);
+                mExternals->Add(object, WrappedJavascriptExternal(external));
+            }
+            else
+            {
+                // Only the functions of collected JavascriptFunctions reached the wrapper.
+                external->Detach(isolate);
+                mExternalPool->Delete(external);
+            }
+        }
+
+        // The finalizers of the collected JavascriptFunctions have queued their functions.
+        ReleasePendingFunctions();
+    }
+    isolate->LowMemoryNotification();
+}
+
+bool
+JavascriptContext::FindCycleCandidates(System::Collections::Generic::List<System::IntPtr>^ candidates, System::Collections::Generic::List<System::Runtime::DependentHandle>^ dependencies)
+{
+    if (mFunctions->Count == 0 || mExternals->Count == 0)
+        return false;
+
+    // Taking the snapshot collects garbage first, so the lists are read afterwards.
+    HandleScope handleScope(isolate);
+    HeapProfiler *profiler = isolate->GetHeapProfiler();
+    const HeapSnapshot *snapshot = profiler->TakeHeapSnapshot();
+
+    std::vector<JavascriptFunctionWrapper *> functions;
+    std::vector<SnapshotObjectId> functionIds;
+    for each (System::IntPtr p in mFunctions)
+    {
+        JavascriptFunctionWrapper *wrapper = (JavascriptFunctionWrapper *)p.ToPointer();
+        functions.push_back(wrapper);
+        functionIds.push_back(profiler->GetObjectId(wrapper->handle->Get(isolate)));
+    }
+
+    cli::array<System::Object^>^ objects = gcnew cli::array<System::Object^>(mExternals->Count);
+    mExternals->Keys->CopyTo(objects, 0);
+    std::vector<SnapshotObjectId> wrapperIds;
+    for each (System::Object^ object in objects)
+    {
+        // Objects that haven't been given a JavaScript object yet, such as delegates, can't be
+        // part of a cycle.
+        JavascriptExternal *external = mExternals[object].Pointer;
+        wrapperIds.push_back(external->mPersistent.IsEmpty() ? HeapProfiler::kUnknownObjectId : profiler->GetObjectId(Local<Object>::New(isolate, external->mPersistent)));
+    }
+
+    std::vector<std::vector<int>> reachedFrom;
+    bool found = FindWrappersReachedOnlyFromFunctions(snapshot, functionIds, wrapperIds, reachedFrom);
+    const_cast<HeapSnapshot *>(snapshot)->Delete();
+    if (!found)
+        return false;
+
+    cli::array<bool>^ isCandidate = gcnew cli::array<bool>(objects->Length);
+    for (size_t i = 0; i < functions.size(); i++)
+    {
+        if (reachedFrom[i].empty())
+            continue;
+        cli::array<System::Object^>^ reached = gcnew cli::array<System::Object^>((int)reachedFrom[i].size());
+        for (size_t j = 0; j < reachedFrom[i].size(); j++)
+        {
+            reached[(int)j] = objects[reachedFrom[i][j]];
+            isCandidate[reachedFrom[i][j]] = true;
+        }
+        // A JavascriptFunction that is waiting to be finalized keeps nothing alive.
+        System::Object^ function = functions[i]->managedHandle.Target;
+        if (function != nullptr)
+            dependencies->Add(System::Runtime::DependentHandle(function, reached));
+    }
+
+    for (int i = 0; i < objects->Length; i++)
+    {
+        if (!isCandidate[i])
+            continue;
+        JavascriptExternal *external = mExternals[objects[i]].Pointer;
+        mExternals->Remove(objects[i]);
+        external->SetObjectHandleWeak(true);
+        candidates->Add(System::IntPtr(external));
+    }
+    return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -533,14 +1737,31 @@ JavascriptContext::WrapObject(System::Object^ iObject)
 	}
 	else
 	{
-		JavascriptExternal* external = new JavascriptExternal(iObject);
+		JavascriptExternal* external = mExternalPool->New(iObject);
 		mExternals[iObject] = WrappedJavascriptExternal(external);
+		// Functions made from delegates point straight at their JavascriptExternal.
+		if (mObjectScope != nullptr && dynamic_cast<System::Delegate^>(iObject) == nullptr)
+			mObjectScope->Track(iObject);
 		return external;
 	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void
+JavascriptContext::ReleaseExternal(System::Object^ iObject)
+{
+	WrappedJavascriptExternal external_wrapped;
+	if (!mExternals->TryGetValue(iObject, external_wrapped))
+		return;  // V8 has already collected it
+
+	mExternals->Remove(iObject);
+	external_wrapped.Pointer->Detach(isolate);
+	mExternalPool->Delete(external_wrapped.Pointer);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 Local<FunctionTemplate>
 JavascriptContext::GetObjectWrapperConstructorTemplate(System::Type ^type)
 {
@@ -558,6 +1779,188 @@ JavascriptContext::GetObjectWrapperConstructorTemplate(System::Type ^type)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Only the V8 strings: the .NET Regex cache is evicted on its own.
+void
+JavascriptContext::ClearRegExpSources()
+{
+    for each (System::IntPtr p in mRegExpSources->Values)
+    {
+        Persistent<String> *source = (Persistent<String> *)(void *)p;
+        source->Reset();
+        delete source;
+    }
+    mRegExpSources->Clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Local<String>
+JavascriptContext::GetInternedString(System::String^ value)
+{
+    System::Collections::Generic::LinkedListNode<System::Collections::Generic::KeyValuePair<System::String^, System::IntPtr>>^ node;
+    if (mInternedStrings->TryGetValue(value, node))
+    {
+        if (node != mInternedStringsByUse->First)
+        {
+            mInternedStringsByUse->Remove(node);
+            mInternedStringsByUse->AddFirst(node);
+        }
+        return ((Persistent<String> *)(void *)node->Value.Value)->Get(isolate);
+    }
+
+    pin_ptr<const wchar_t> valuePtr = PtrToStringChars(value);
+    Local<String> result = String::NewFromTwoByte(isolate, (uint16_t *)valuePtr, v8::NewStringType::kInternalized, value->Length).ToLocalChecked();
+
+    // Also shrinks the cache after StringCacheSize has been lowered.
+    while (mInternedStringsByUse->Count > 0 && mInternedStringsByUse->Count >= mStringCacheSize)
+    {
+        auto leastRecentlyUsed = mInternedStringsByUse->Last->Value;
+        Persistent<String> *evicted = (Persistent<String> *)(void *)leastRecentlyUsed.Value;
+        evicted->Reset();
+        delete evicted;
+        mInternedStrings->Remove(leastRecentlyUsed.Key);
+        mInternedStringsByUse->RemoveLast();
+    }
+
+    if (mStringCacheSize > 0)
+    {
+        System::Collections::Generic::KeyValuePair<System::String^, System::IntPtr> entry(value, System::IntPtr(new Persistent<String>(isolate, result)));
+        mInternedStrings->Add(value, mInternedStringsByUse->AddFirst(entry));
+    }
+    return result;
+}
+
+void
+JavascriptContext::ClearInternedStrings()
+{
+    for each (System::Collections::Generic::KeyValuePair<System::String^, System::IntPtr> entry in mInternedStringsByUse)
+    {
+        Persistent<String> *string = (Persistent<String> *)(void *)entry.Value;
+        string->Reset();
+        delete string;
+    }
+    mInternedStringsByUse->Clear();
+    mInternedStrings->Clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static const int kMaxMappedFileViews = 64;
+
+std::shared_ptr<BackingStore>
+JavascriptContext::GetMappedFileView(MappedFileSection *section)
+{
+    System::IntPtr key(section);
+    System::IntPtr entry;
+    if (mMappedFileViews->TryGetValue(key, entry))
+    {
+        // A live view keeps its section, so the address can't belong to another file meanwhile.
+        std::shared_ptr<BackingStore> view = ((std::weak_ptr<BackingStore> *)entry.ToPointer())->lock();
+        if (view)
+            return view;
+    }
+    else if (mMappedFileViews->Count >= kMaxMappedFileViews)
+    {
+        // Only views that are still in use have to be remembered.
+        System::Collections::Generic::List<System::IntPtr>^ unmapped = gcnew System::Collections::Generic::List<System::IntPtr>();
+        for each (System::Collections::Generic::KeyValuePair<System::IntPtr, System::IntPtr> mapped in mMappedFileViews)
+            if (((std::weak_ptr<BackingStore> *)mapped.Value.ToPointer())->expired())
+                unmapped->Add(mapped.Key);
+        for each (System::IntPtr p in unmapped)
+        {
+            delete (std::weak_ptr<BackingStore> *)mMappedFileViews[p].ToPointer();
+            mMappedFileViews->Remove(p);
+        }
+    }
+
+    DWORD error;
+    std::shared_ptr<BackingStore> view = section->NewView(&error);
+    if (!view)
+        throw gcnew System::IO::IOException(System::String::Format("Could not map a view of a file: {0}", (gcnew System::ComponentModel::Win32Exception(error))->Message), HRESULT_FROM_WIN32(error));
+
+    if (entry != System::IntPtr::Zero)
+        *(std::weak_ptr<BackingStore> *)entry.ToPointer() = view;
+    else
+        mMappedFileViews->Add(key, System::IntPtr(new std::weak_ptr<BackingStore>(view)));
+    return view;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Called before any script has run, so that scripts replacing `Date` or its methods can't
+// change how dates are converted.
+void
+JavascriptContext::CaptureDateFunctions(Local<Context> context)
+{
+    Context::Scope contextScope(context);
+    Local<Value> dateConstructor = context->Global()->Get(context, String::NewFromUtf8Literal(isolate, "Date")).ToLocalChecked();
+    mDateConstructor = new Persistent<Function>(isolate, dateConstructor.As<Function>());
+    Local<Value> prototype = dateConstructor.As<Function>()->Get(context, String::NewFromUtf8Literal(isolate, "prototype")).ToLocalChecked();
+    Local<Value> getTimezoneOffset = prototype.As<v8::Object>()->Get(context, String::NewFromUtf8Literal(isolate, "getTimezoneOffset")).ToLocalChecked();
+    mDateGetTimezoneOffset = new Persistent<Function>(isolate, getTimezoneOffset.As<Function>());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Local<Function>
+JavascriptContext::GetDateConstructor()
+{
+    return mDateConstructor->Get(isolate);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Local<Function>
+JavascriptContext::GetDateTimezoneOffsetFunction()
+{
+    return mDateGetTimezoneOffset->Get(isolate);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Releases the JavascriptFunctionWrappers queued by JavascriptFunction's finalizer.  Must be called
+// with the context entered.
+void
+JavascriptContext::ReleasePendingFunctions()
+{
+    System::ValueTuple<System::IntPtr, long long> pending;
+    long long oldest = 0;
+    while (mPendingReleases->TryDequeue(pending))
+    {
+        if (oldest == 0)
+            oldest = pending.Item2;
+        JavascriptFunction::Release(this, (JavascriptFunctionWrapper *)pending.Item1.ToPointer());
+    }
+    if (oldest != 0)
+        System::Threading::Interlocked::Exchange(mReleaseLatencyTicks, System::Diagnostics::Stopwatch::GetTimestamp() - oldest);
+}
+
+// Releases the scripts queued by JavascriptScript's finalizer.  Must be called with the isolate
+// locked.
+void
+JavascriptContext::ReleasePendingScripts()
+{
+    System::IntPtr pending;
+    while (mPendingScriptReleases->TryDequeue(pending))
+    {
+        Persistent<UnboundScript> *script = (Persistent<UnboundScript> *)pending.ToPointer();
+        script->Reset();
+        delete script;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Local<Private>
+JavascriptContext::GetFunctionWrapperKey()
+{
+    if (mFunctionWrapperKey == nullptr)
+        mFunctionWrapperKey = new Persistent<Private>(isolate, Private::New(isolate, String::NewFromUtf8Literal(isolate, "JavascriptFunctionWrapper")));
+    return mFunctionWrapperKey->Get(isolate);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 System::String^ JavascriptContext::V8Version::get()
 {
 	return gcnew System::String(v8::V8::GetVersion());
@@ -568,14 +1971,128 @@ bool JavascriptContext::IsV8Initialized::get()
     return initialized;
 }
 
+bool JavascriptContext::IsMemorySharingSupported::get()
+{
+#ifdef V8_ENABLE_SANDBOX
+    return false;
+#else
+    return true;
+#endif
+}
+
+int JavascriptContext::RegexCompilationThreshold::get()
+{
+    return mRegexCompilationThreshold;
+}
+
+void JavascriptContext::RegexCompilationThreshold::set(int value)
+{
+    if (value < 0)
+        throw gcnew System::ArgumentOutOfRangeException("value");
+    mRegexCompilationThreshold = value;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Local<Script>
-CompileScript(v8::Isolate *isolate, wchar_t const *source_code, wchar_t const *resource_name)
+int JavascriptContext::StringCacheSize::get()
+{
+    return mStringCacheSize;
+}
+
+void JavascriptContext::StringCacheSize::set(int value)
 {
-	// convert source
-	Local<String> source = String::NewFromTwoByte(isolate, (uint16_t const *)source_code, v8::NewStringType::kNormal).ToLocalChecked();
+    if (value < 0)
+        throw gcnew System::ArgumentOutOfRangeException("value");
+    mStringCacheSize = value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int JavascriptContext::ExternalStringThreshold::get()
+{
+    return mExternalStringThreshold;
+}
 
+void JavascriptContext::ExternalStringThreshold::set(int value)
+{
+    if (value < 0)
+        throw gcnew System::ArgumentOutOfRangeException("value");
+    mExternalStringThreshold = value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+long long JavascriptContext::ExternalObjectSize::get()
+{
+    return mExternalObjectSize;
+}
+
+void JavascriptContext::ExternalObjectSize::set(long long value)
+{
+    if (value < 0)
+        throw gcnew System::ArgumentOutOfRangeException("value");
+    mExternalObjectSize = value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int JavascriptContext::FunctionCount::get()
+{
+    return mFunctions->Count;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int JavascriptContext::ExternalCount::get()
+{
+    return mExternals->Count;
+}
+
+long long JavascriptContext::ExternalMemory::get()
+{
+    return mExternalMemory;
+}
+
+void JavascriptContext::AdjustExternalMemory(long long change)
+{
+    mExternalMemory += change;
+    isolate->AdjustAmountOfExternalAllocatedMemory(change);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int JavascriptContext::PendingFunctionReleases::get()
+{
+    return mPendingReleases->Count;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+System::TimeSpan JavascriptContext::FunctionReleaseLatency::get()
+{
+    long long ticks = System::Threading::Interlocked::Read(mReleaseLatencyTicks);
+    return System::TimeSpan::FromSeconds((double)ticks / System::Diagnostics::Stopwatch::Frequency);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TypedArrayConversion JavascriptContext::PrimitiveArrayConversion::get()
+{
+    return mPrimitiveArrayConversion;
+}
+
+void JavascriptContext::PrimitiveArrayConversion::set(TypedArrayConversion value)
+{
+    if (value < TypedArrayConversion::None || value > TypedArrayConversion::Share)
+        throw gcnew System::ArgumentOutOfRangeException("value");
+    mPrimitiveArrayConversion = value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Local<Script>
+CompileScript(v8::Isolate *isolate, Local<String> source, wchar_t const *resource_name)
+{
 	// compile
 	{
 		TryCatch tryCatch(isolate);
@@ -588,8 +2105,8 @@ CompileScript(v8::Isolate *isolate, wchar_t const *source_code, wchar_t const *r
 		else
 		{
 			Local<String> resource = String::NewFromTwoByte(isolate, (uint16_t const *)resource_name, v8::NewStringType::kNormal).ToLocalChecked();
-            ScriptOrigin *origin = new ScriptOrigin(resource);
-			script = Script::Compile(JavascriptContext::GetCurrentIsolate()->GetCurrentContext(), source, origin);
+            ScriptOrigin origin(resource);
+			script = Script::Compile(JavascriptContext::GetCurrentIsolate()->GetCurrentContext(), source, &origin);
 		}
 
 		if (script.IsEmpty())
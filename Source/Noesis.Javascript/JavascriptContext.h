@@ -48,6 +48,12 @@ using namespace std;
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 class JavascriptExternal;
+class JavascriptExternalPool;
+class MappedFileSection;
+ref class JavascriptArrayBuffer;
+ref class JavascriptScript;
+ref class JavascriptWasmModule;
+ref class JavascriptObjectScope;
 
 [System::Flags]
 public enum class SetParameterOptions : int
@@ -56,6 +62,57 @@ public enum class SetParameterOptions : int
     RejectUnknownProperties = 1
 };
 
+/// <summary>
+/// How one-dimensional arrays of numeric primitives (byte[], double[], ...), and Memory,
+/// ReadOnlyMemory and ArraySegment over them, are passed to JavaScript.
+/// </summary>
+public enum class TypedArrayConversion : int
+{
+    /// <summary>A plain JavaScript Array with one Number per element.</summary>
+    None = 0,
+    /// <summary>A typed array (Uint8Array, Float64Array, ...) over a copy of the data.</summary>
+    Copy = 1,
+    /// <summary>
+    /// A typed array directly over the .NET memory, which stays pinned until V8 has collected
+    /// the typed array.  Writes on either side are visible to the other.  Falls back to Copy
+    /// when V8 is built with its sandbox enabled.
+    /// </summary>
+    Share = 2
+};
+
+/// <summary>
+/// Locates and loads the ES modules run by JavascriptContext.RunModule() or imported by scripts.
+/// </summary>
+public interface class IModuleResolver
+{
+    /// <summary>
+    /// Returns the identifier (e.g. full path or URL) of the module that `specifier` refers to.  A
+    /// context only loads the module with a given identifier once.
+    /// </summary>
+    /// <param name="referrer">
+    /// The identifier of the importing module, the resource name of the importing script, or null.
+    /// </param>
+    System::String^ Resolve(System::String^ specifier, System::String^ referrer);
+
+    /// <summary>
+    /// Returns the source code of the module with the given identifier.
+    /// </summary>
+    System::String^ Load(System::String^ identifier);
+};
+
+/// <summary>
+/// Implemented by .NET objects that know roughly how much memory they keep alive, so that
+/// V8 can take it into account when deciding when to collect their JavaScript objects.
+/// </summary>
+public interface class IJavascriptSizeHint
+{
+    /// <summary>
+    /// Bytes of memory the object accounts for.  Read once, when the object is first passed
+    /// to JavaScript.
+    /// </summary>
+    property long long JavascriptSize { long long get(); }
+};
+
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // WrappedMethod
@@ -116,14 +173,13 @@ internal:
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 ref class JavascriptFunction;  // Forward declaration
 
-// Native wrapper that holds both V8 handle and weak reference to managed object
+// Native side of a JavascriptFunction.  A pointer to it is stored on the JS function under
+// JavascriptContext::GetFunctionWrapperKey(), so both directions find it without a search.
 struct JavascriptFunctionWrapper
 {
     v8::Persistent<v8::Function>* handle;
     System::Runtime::InteropServices::GCHandle managedHandle;
     
-    JavascriptFunctionWrapper() : handle(nullptr) {}
-    
     JavascriptFunctionWrapper(v8::Persistent<v8::Function>* h, JavascriptFunction^ func) 
         : handle(h)
     {
@@ -134,31 +190,53 @@ struct JavascriptFunctionWrapper
     }
 };
 
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-// WrappedJavascriptFunction
+// CachedRegex
 //
-// Wraps a pointer to JavascriptFunctionWrapper for storage in managed dictionary.
-// Similar pattern to WrappedMethod and WrappedJavascriptExternal.
+// Entry in JavascriptContext's cache of regular expressions converted from JavaScript.
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-public value struct WrappedJavascriptFunction
+ref class CachedRegex
 {
-private:
-    System::IntPtr pointer;
+internal:
+    System::Text::RegularExpressions::Regex^ regex;
+    int conversions;
+};
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// ScriptFile
+//
+// Entry in JavascriptContext's process-wide cache of script files run by RunFile() or CompileFile().
+////////////////////////////////////////////////////////////////////////////////////////////////////
+ref class ScriptFile
+{
 internal:
-    WrappedJavascriptFunction(JavascriptFunctionWrapper* value)
-    {
-        System::IntPtr value_pointer(value);
-        pointer = value_pointer;
-    }
+    ~ScriptFile() { this->!ScriptFile(); }
+    !ScriptFile();
 
-    property JavascriptFunctionWrapper* Pointer
-    {
-        JavascriptFunctionWrapper* get()
-        {
-            return (JavascriptFunctionWrapper*)(void*)pointer;
-        }
-    }
+    System::String^ path;
+    System::DateTime lastWriteTimeUtc;
+    long long length;
+
+    // Points to the `MappedScriptSource` holding the mapped file.  Every external string created
+    // over it holds its own reference, so replacing this entry doesn't pull the file out from under
+    // contexts that are still using it.
+    System::IntPtr source;
+
+    // V8's code cache for the script, once a context has compiled it.
+    cli::array<unsigned char>^ codeCache;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// CachedModuleCode
+//
+// Entry in JavascriptContext's process-wide cache of V8's code caches for ES modules.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+ref class CachedModuleCode
+{
+internal:
+    System::String^ source;
+    cli::array<unsigned char>^ codeCache;
 };
 
 
@@ -197,6 +275,74 @@ public:
 	virtual System::Object^ Run(System::String^ iSourceCode);
 
 	virtual System::Object^ Run(System::String^ iScript, System::String^ iScriptResourceName);
+
+    /// <summary>
+    /// Runs a script file.  Rather than being read into a .NET string and copied into every context,
+    /// the file is mapped into memory once and V8 parses it in place, for all contexts in the
+    /// process.  This works for ASCII files and for UTF-16 files with a byte order mark; other UTF-8
+    /// files still have to be decoded into each context.  The code V8 compiled for the file is cached
+    /// as well, so that other contexts skip most of the compilation.
+    /// </summary>
+    /// <remarks>
+    /// The mapping and the code cache are replaced once the file's size or last write time changes.
+    /// The file should not be modified in place while contexts still use it, but it can be replaced.
+    /// </remarks>
+    System::Object^ RunFile(System::String^ path);
+
+    /// <summary>
+    /// Compiles a script file like RunFile(), so that it can be run later, possibly more than once.
+    /// </summary>
+    JavascriptScript^ CompileFile(System::String^ path);
+
+    /// <summary>
+    /// Compiles a script on a background thread while it is being read.  V8 parses the text as it
+    /// arrives without holding this context's lock, so other threads can keep running scripts in the
+    /// meantime.  The lock is only taken for the final step.  Disposing the context waits for
+    /// compilations that are still in progress.
+    /// </summary>
+    System::Threading::Tasks::Task<JavascriptScript^>^ CompileAsync(System::IO::TextReader^ reader, System::String^ resourceName);
+
+    /// <summary>
+    /// Like CompileAsync(TextReader, String), reading the script from a UTF-8 stream.
+    /// </summary>
+    System::Threading::Tasks::Task<JavascriptScript^>^ CompileAsync(System::IO::Stream^ stream, System::String^ resourceName);
+
+    /// <summary>
+    /// Runs an ES module and the modules it imports, and returns its exports.  Modules are located
+    /// through ModuleResolver, and each module is compiled only once per context.  V8's code caches
+    /// for modules are shared by all contexts, so a module that another context has already loaded
+    /// is cheap to compile.
+    /// </summary>
+    System::Object^ RunModule(System::String^ specifier);
+
+    /// <summary>
+    /// Compiles a function that takes the given parameters.  Calling it passes values positionally,
+    /// so evaluating the same code for many inputs needs neither SetParameter() nor a new compile.
+    /// </summary>
+    /// <param name="body">The function's body, so expressions need a `return`.</param>
+    JavascriptFunction^ CompileFunction(System::String^ body, ... cli::array<System::String^>^ parameterNames);
+
+    /// <summary>
+    /// Locates modules for RunModule() and for import() in scripts and modules.  Scripts can't import
+    /// modules while it is null, which is the default.
+    /// </summary>
+    property IModuleResolver^ ModuleResolver { IModuleResolver^ get(); void set(IModuleResolver^ value); }
+
+    /// <summary>
+    /// Compiles a WebAssembly module, which can then be passed to any context with SetParameter()
+    /// without compiling it again.  Compiled code is cached by a hash of the bytes, so compiling the
+    /// same bytes again, in any context, only costs the hash.  Each call returns a new object, which
+    /// the caller may dispose without affecting the others.
+    /// </summary>
+    JavascriptWasmModule^ CompileWasmModule(cli::array<unsigned char>^ wireBytes);
+
+    /// <summary>
+    /// Begins a scope at the end of which the .NET objects passed to JavaScript during it are
+    /// released, e.g. `using (context.BeginScope()) { ... }` around each request handled by a
+    /// pooled context.  Without a scope they are only released once V8 collects their JavaScript
+    /// objects, which may not happen for a long time.
+    /// </summary>
+    JavascriptObjectScope^ BeginScope();
 		
 	property static System::String^ V8Version { System::String^ get(); }
 	
@@ -206,6 +352,79 @@ public:
     /// </summary>
     property static bool IsV8Initialized { bool get(); }
 
+    /// <summary>
+    /// Whether JavaScript can work directly on memory owned by .NET.  This is not the case when V8 is
+    /// built with its sandbox enabled, and TypedArrayConversion.Share then falls back to copying.
+    /// </summary>
+    property static bool IsMemorySharingSupported { bool get(); }
+
+    /// <summary>
+    /// Number of times a JavaScript regular expression with the same source and flags has to be converted
+    /// to .NET before the cached Regex is recreated with RegexOptions.Compiled. Compiling is expensive, so
+    /// it only pays off for patterns that are used over and over. Zero (the default) never compiles.
+    /// </summary>
+    property int RegexCompilationThreshold { int get(); void set(int value); }
+
+    /// <summary>
+    /// How arrays of numeric primitives are converted when passed to JavaScript.  Defaults to
+    /// None, which creates ordinary JavaScript arrays.
+    /// </summary>
+    property TypedArrayConversion PrimitiveArrayConversion { TypedArrayConversion get(); void set(TypedArrayConversion value); }
+
+    /// <summary>
+    /// Number of names (of parameters, dictionary keys up to 32 characters, enum values, ...) for
+    /// which the V8 string is kept after converting them to JavaScript, so that converting them again
+    /// only costs a lookup.  String values are never cached.  The least recently used string is
+    /// dropped when the cache is full.  Zero disables the cache.  Defaults to 1024.
+    /// </summary>
+    property int StringCacheSize { int get(); void set(int value); }
+
+    /// <summary>
+    /// Strings passed to JavaScript (including script sources) that have at least this many characters
+    /// are not copied into the V8 heap.  V8 uses the pinned .NET string instead, until it collects the
+    /// JavaScript string.  This saves copying large documents, but keeps them pinned in the .NET heap.
+    /// Zero (the default) always copies.
+    /// </summary>
+    property int ExternalStringThreshold { int get(); void set(int value); }
+
+    /// <summary>
+    /// Bytes of memory V8 is told each .NET object passed to JavaScript keeps alive, unless it
+    /// implements IJavascriptSizeHint.  The larger this is, the sooner V8 collects the JavaScript
+    /// objects (and so releases the .NET objects).  Zero (the default) reports nothing.
+    /// </summary>
+    property long long ExternalObjectSize { long long get(); void set(long long value); }
+
+    /// <summary>
+    /// Number of JavaScript functions that currently have a JavascriptFunction in .NET.  Each is
+    /// released when the JavascriptFunction is disposed or finalized.
+    /// </summary>
+    property int FunctionCount { int get(); }
+
+    /// <summary>
+    /// Number of .NET objects that currently have a JavaScript object in this context.  Each is
+    /// released when V8 collects its JavaScript object.
+    /// </summary>
+    property int ExternalCount { int get(); }
+
+    /// <summary>
+    /// Bytes of memory V8 has been told the .NET objects counted by ExternalCount keep alive, from
+    /// ExternalObjectSize or IJavascriptSizeHint.
+    /// </summary>
+    property long long ExternalMemory { long long get(); }
+
+    /// <summary>
+    /// Number of finalized JavascriptFunctions whose JavaScript function has not been released yet.
+    /// Finalizers don't wait for a running script, so they leave that to the next time the context
+    /// is entered.
+    /// </summary>
+    property int PendingFunctionReleases { int get(); }
+
+    /// <summary>
+    /// How long the longest waiting of the functions released the last time the context was entered
+    /// had been waiting since its JavascriptFunction was finalized.
+    /// </summary>
+    property System::TimeSpan FunctionReleaseLatency { System::TimeSpan get(); }
+
     System::Collections::Generic::List<JavascriptStackFrame^>^ GetCurrentStack(int maxDepth);
 
 	void TerminateExecution();
@@ -217,6 +436,9 @@ public:
 
     bool IsExecutionTerminating();
 
+	// Runs a full garbage collection of the context's isolate, including cycles through .NET
+	// objects that hold JavascriptFunctions.  Neither garbage collector finds those on its own,
+	// so long-lived contexts should call this now and then.
 	void Collect();
 
 	// Fatal errors can occur when v8 runs out of memory.  Your process
@@ -230,6 +452,26 @@ public:
 
     static void SetFlags(System::String^ flags);
 
+    /// <summary>
+    /// Maps a file into memory and returns it as an ArrayBuffer that can be passed to any context, in
+    /// any isolate, without copying.  The mapping is released once the returned object has been
+    /// disposed or finalized and every JavaScript reference to it has been collected.
+    /// </summary>
+    /// <param name="readOnly">
+    /// When true, the file is opened for reading only and writes never reach it.  When false, the
+    /// file is opened for writing and changes go to it.
+    /// </param>
+    /// <remarks>
+    /// A read-only mapping is still writable memory, but each context the returned object is passed
+    /// to gets a copy-on-write view of its own, as does Data.  The views share the file's pages until
+    /// one of them is written to, so a write made by one script is never seen by another context.  A
+    /// context keeps its view while JavaScript holds on to a buffer over it.  A writable mapping is
+    /// a single view, shared by every context.
+    /// When V8 is built with its sandbox (see IsMemorySharingSupported), the file is copied into V8's
+    /// memory instead, and writes never reach the file.
+    /// </remarks>
+    static JavascriptArrayBuffer^ MapFile(System::String^ path, bool readOnly);
+
 	////////////////////////////////////////////////////////////
 	// Internal methods
 	////////////////////////////////////////////////////////////
@@ -248,8 +490,38 @@ internal:
 
 	JavascriptExternal* WrapObject(System::Object^ iObject);
 
+    // Detaches and frees the JavascriptExternal of the object, if it still has one.
+    void ReleaseExternal(System::Object^ iObject);
+
+    void EndScope(JavascriptObjectScope^ scope);
+
 	Local<FunctionTemplate> GetObjectWrapperConstructorTemplate(System::Type ^type);
 
+    Local<Function> GetDateConstructor();
+
+    Local<Function> GetDateTimezoneOffsetFunction();
+
+    void CaptureDateFunctions(Local<Context> context);
+
+    Local<Private> GetFunctionWrapperKey();
+
+    void ReleasePendingFunctions();
+
+    void ReleasePendingScripts();
+
+    // This context's view of a read-only mapped file, created on first use.
+    std::shared_ptr<BackingStore> GetMappedFileView(MappedFileSection *section);
+
+    Local<String> GetInternedString(System::String^ value);
+
+    // Runs a script compiled in this context, converting the result to .NET.
+    System::Object^ RunCompiledScript(Local<Script> script);
+
+    // Loads and instantiates a module with its dependencies, for RunModule() and import().
+    Local<Module> InstantiateModule(System::String^ specifier, System::String^ referrer);
+
+    Local<Module> GetModule(Local<String> specifier, Local<Module> referrer);
+
 	static void FatalErrorCallbackMember(const char* location, const char* message);
 
     inline bool IsDisposed() { return mContext == nullptr; }
@@ -261,16 +533,134 @@ public:
     // Stores every JavascriptExternal we create.  This saves time if the same
     // objects are recreated frequently, and stops us building up a huge
     // collection of JavascriptExternal objects that won't be freed until
-    // the context is destroyed.
+    // the context is destroyed.  Keyed by object identity: objects that
+    // override Equals() still each get their own JavaScript object.
     System::Collections::Generic::Dictionary<System::Object^, WrappedJavascriptExternal>^ mExternals;
 internal:
 
-    // Stores JavascriptFunction wrappers keyed by V8 function identity hash.
-    // Entries are automatically removed by GC callback when V8 collects the function.
-    // This prevents memory leaks from accumulating function wrappers.
-    System::Collections::Generic::Dictionary<int, WrappedJavascriptFunction>^ mFunctions;
+    // Where the JavascriptExternals in mExternals are allocated.
+    JavascriptExternalPool* mExternalPool;
+
+    // The innermost JavascriptObjectScope that hasn't ended, if any.
+    JavascriptObjectScope^ mObjectScope;
+
+    // Every JavascriptFunctionWrapper of this context, so they can be freed with it.  Entries
+    // are removed when the JavascriptFunction is disposed or its finalizer's release is processed.
+    System::Collections::Generic::HashSet<System::IntPtr>^ mFunctions;
+
+    // JavascriptFunctionWrappers of finalized JavascriptFunctions, with the Stopwatch timestamp at
+    // which they were queued.  Released by Enter().
+    System::Collections::Concurrent::ConcurrentQueue<System::ValueTuple<System::IntPtr, long long>>^ mPendingReleases;
+
+    // Stopwatch ticks between the oldest entry of the last batch being queued and released.
+    long long mReleaseLatencyTicks;
+
+    // The `Persistent<UnboundScript>`s of finalized JavascriptScripts.  Released by Enter().
+    System::Collections::Concurrent::ConcurrentQueue<System::IntPtr>^ mPendingScriptReleases;
 
     System::Collections::Generic::Dictionary<System::String^, WrappedMethod>^ mMethods;
+
+    // The objects that the functions in mMethods were created for, indexed by the number in the
+    // function's data.  Called without a .NET `this`, a method falls back to its object.
+    System::Collections::Generic::List<System::WeakReference^>^ mMethodTargets;
+
+    // Regular expressions converted from JavaScript, keyed by source and RegExp::Flags.  .NET
+    // Regex objects are immutable, so one instance can be handed out for every conversion.
+    System::Collections::Generic::Dictionary<System::ValueTuple<System::String^, int>, CachedRegex^>^ mRegexCache;
+
+    // Internalized V8 strings for the patterns of .NET Regex objects converted to JavaScript.
+    // We can't share the RegExp objects themselves because scripts mutate them (lastIndex),
+    // but V8 keeps its compiled code keyed by source, so a fresh RegExp is cheap to create.
+    // The `IntPtr` points to a `Persistent<String>`.
+    System::Collections::Generic::Dictionary<System::String^, System::IntPtr>^ mRegExpSources;
+
+    // The JavaScript flags (g, s, u, y, ...) of every Regex we created from a RegExp, so that
+    // converting it back yields the same flags even though .NET has no equivalent options.
+    static System::Runtime::CompilerServices::ConditionalWeakTable<System::Text::RegularExpressions::Regex^, System::Object^>^ sRegexFlags =
+        gcnew System::Runtime::CompilerServices::ConditionalWeakTable<System::Text::RegularExpressions::Regex^, System::Object^>();
+
+    int mRegexCompilationThreshold;
+
+    TypedArrayConversion mPrimitiveArrayConversion;
+
+    // Internalized V8 strings for recently converted names and keys.  The list is ordered by
+    // last use, most recent first.  The `IntPtr`s point to `Persistent<String>`s.
+    System::Collections::Generic::Dictionary<System::String^, System::Collections::Generic::LinkedListNode<System::Collections::Generic::KeyValuePair<System::String^, System::IntPtr>>^>^ mInternedStrings;
+    System::Collections::Generic::LinkedList<System::Collections::Generic::KeyValuePair<System::String^, System::IntPtr>>^ mInternedStringsByUse;
+
+    int mStringCacheSize;
+
+    int mExternalStringThreshold;
+
+    long long mExternalObjectSize;
+
+    // What has been reported to V8 with AdjustExternalMemory().
+    long long mExternalMemory;
+
+    // Reports memory kept alive by the .NET objects of JavascriptExternals to V8.
+    void AdjustExternalMemory(long long change);
+
+    // Makes .NET hold the objects that JavaScript only reaches through JavascriptFunctions weakly,
+    // and through those JavascriptFunctions.  Not inlined into Collect(), so that none of the
+    // objects is left on its stack during the collection.
+    [System::Runtime::CompilerServices::MethodImpl(System::Runtime::CompilerServices::MethodImplOptions::NoInlining)]
+    bool FindCycleCandidates(System::Collections::Generic::List<System::IntPtr>^ candidates, System::Collections::Generic::List<System::Runtime::DependentHandle>^ dependencies);
+
+    void ClearInternedStrings();
+
+    void ClearRegExpSources();
+
+    // Views of read-only mapped files that JavaScript may still use, keyed by MappedFileSection.
+    // The `IntPtr`s point to `std::weak_ptr<BackingStore>`s, so that a view is unmapped as soon as
+    // JavaScript has dropped every buffer over it.
+    System::Collections::Generic::Dictionary<System::IntPtr, System::IntPtr>^ mMappedFileViews;
+
+    // Script files run or compiled by any context, keyed by full path.  Cleared once it holds
+    // kMaxScriptFiles files; the finalizers of the dropped entries then unmap the files.
+    static System::Collections::Generic::Dictionary<System::String^, ScriptFile^>^ sScriptFiles =
+        gcnew System::Collections::Generic::Dictionary<System::String^, ScriptFile^>(System::StringComparer::OrdinalIgnoreCase);
+
+    static ScriptFile^ GetScriptFile(System::String^ path);
+
+    Local<UnboundScript> CompileScriptFile(ScriptFile^ file);
+
+    static void StoreCodeCache(ScriptFile^ file, Local<UnboundScript> script);
+
+    IModuleResolver^ mModuleResolver;
+
+    // The modules loaded by this context, keyed by identifier.  The `IntPtr`s point to
+    // `Persistent<Module>`s.
+    System::Collections::Generic::Dictionary<System::String^, System::IntPtr>^ mModules;
+
+    // Identifiers of the modules in mModules, keyed by Module::ScriptId().
+    System::Collections::Generic::Dictionary<int, System::String^>^ mModuleIdentifiers;
+
+    // Identifiers of imported modules, keyed by the importing module's identifier and the specifier.
+    System::Collections::Generic::Dictionary<System::ValueTuple<System::String^, System::String^>, System::String^>^ mResolvedModules;
+
+    // V8's code caches for modules compiled by any context, keyed by identifier.  Cleared once it
+    // holds kMaxCachedModuleCodes entries.
+    static System::Collections::Generic::Dictionary<System::String^, CachedModuleCode^>^ sModuleCodeCaches =
+        gcnew System::Collections::Generic::Dictionary<System::String^, CachedModuleCode^>();
+
+    // WebAssembly modules compiled by CompileWasmModule(), keyed by the SHA-256 of their bytes.
+    // These are never handed out, callers get copies.  Cleared once it holds kMaxCachedWasmModules
+    // modules.
+    static System::Collections::Generic::Dictionary<System::String^, JavascriptWasmModule^>^ sWasmModules =
+        gcnew System::Collections::Generic::Dictionary<System::String^, JavascriptWasmModule^>();
+
+    Local<Module> LoadModule(System::String^ identifier);
+
+    Local<Module> LoadModule(System::String^ identifier, System::Collections::Generic::List<System::String^>^ loaded);
+
+    void UnloadModules(System::Collections::Generic::List<System::String^>^ identifiers);
+
+    Local<Module> CompileModule(System::String^ identifier, System::String^ source);
+
+    System::String^ ResolveModule(System::String^ specifier, System::String^ referrer);
+
+    // Counts CompileAsync() calls that are still using the isolate, plus one for the context itself.
+    System::Threading::CountdownEvent^ mPendingCompilations;
 protected:
 	// By entering an isolate before using a context, we can have multiple
 	// contexts used simultaneously in different threads.
@@ -285,6 +675,15 @@ protected:
     // The `IntPtr` points to a `Persistent<FunctionTemplate>`.
     System::Collections::Generic::Dictionary<System::Type ^, System::IntPtr> ^mTypeToConstructorMapping;
 
+    // The built-in `Date` constructor and `Date.prototype.getTimezoneOffset` of this context.
+    // Captured when the context is created, so date conversions neither go through the global
+    // object by name every time nor pick up replacements installed by scripts.
+    Persistent<Function>* mDateConstructor;
+    Persistent<Function>* mDateGetTimezoneOffset;
+
+    // Private symbol under which JS functions passed to .NET keep their JavascriptFunctionWrapper.
+    Persistent<Private>* mFunctionWrapperKey;
+
 	// See comment for TerminateExecution().
 	bool terminateRuns;
 
@@ -324,7 +723,7 @@ public:
 // Standalone functions - can be called from unmanaged code too
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Local<Script> CompileScript(v8::Isolate *isolate, wchar_t const *source_code, wchar_t const *resource_name = NULL);
+Local<Script> CompileScript(v8::Isolate *isolate, Local<String> source, wchar_t const *resource_name = NULL);
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
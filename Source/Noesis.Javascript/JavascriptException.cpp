@@ -139,7 +139,7 @@ JavascriptException::GetSystemException(TryCatch& iTryCatch)
 		v8::Local<v8::Object> exception_o = v8::Local<v8::Object>::Cast(v8exception);
         auto isolate = JavascriptContext::GetCurrentIsolate();
         auto context = isolate->GetCurrentContext();
-		v8::Local<v8::String> inner_exception_str = v8::String::NewFromUtf8(isolate, "InnerException", v8::NewStringType::kNormal).ToLocalChecked();
+		v8::Local<v8::String> inner_exception_str = JavascriptContext::GetCurrent()->GetInternedString("InnerException");
 		if (exception_o->HasOwnProperty(context, inner_exception_str).FromMaybe(false)) {
 			v8::Local<v8::Value> inner = exception_o->Get(context, inner_exception_str).ToLocalChecked();
 			System::Object^ object = JavascriptInterop::UnwrapObject(inner);
@@ -34,6 +34,7 @@
 #include "SystemInterop.h"
 
 #include <stdio.h>
+#include <new>
 #include <string>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -53,6 +54,7 @@ JavascriptExternal::JavascriptExternal(System::Object^ iObject)
     System::Runtime::InteropServices::GCHandle handle = System::Runtime::InteropServices::GCHandle::Alloc(iObject, System::Runtime::InteropServices::GCHandleType::Normal);
     mObjectHandle = System::Runtime::InteropServices::GCHandle::ToIntPtr(handle);
     mOptions = SetParameterOptions::None;
+    mExternalSize = 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -79,20 +81,29 @@ void GCCallback(const WeakCallbackInfo<JavascriptExternal>& data)
     auto external = data.GetParameter();
     auto object = external->GetObject();
 
-    if (object != nullptr) {
-        if (context->mExternals->ContainsKey(object)) {
-            context->mExternals->Remove(object);
-        }
-    }
-    delete external;
+    if (object != nullptr)
+        context->mExternals->Remove(object);
+    if (external->GetExternalSize() != 0)
+        context->AdjustExternalMemory(-external->GetExternalSize());
+    context->mExternalPool->Delete(external);
 }
 
 void
 JavascriptExternal::InitializePersistent(Isolate* isolate, Local<Object> object)
 {
+    // Let V8 know what the object costs, so it doesn't hold on to it as if it were free.  The size
+    // hint is user code, so it is read first: if it throws, nothing has been set up yet.
+    auto context = JavascriptContext::GetCurrent();
+    auto sizeHint = dynamic_cast<IJavascriptSizeHint^>(GetObject());
+    int64_t size = sizeHint != nullptr ? sizeHint->JavascriptSize : context->ExternalObjectSize;
+
     object->SetInternalField(0, External::New(isolate, this));
     mPersistent.Reset(isolate, object);
     mPersistent.SetWeak(this, &GCCallback, WeakCallbackType::kParameter);
+
+    mExternalSize = size > 0 ? size : 0;
+    if (mExternalSize != 0)
+        context->AdjustExternalMemory(mExternalSize);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -117,6 +128,50 @@ JavascriptExternal::ToLocal(Isolate* isolate)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+JavascriptExternal*
+JavascriptExternal::FromObject(Local<Object> iObject)
+{
+    Local<Value> field = iObject->GetInternalField(0).As<Value>();
+    if (!field->IsExternal())
+        return nullptr;
+    return (JavascriptExternal*)field.As<External>()->Value();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void
+JavascriptExternal::Detach(Isolate* isolate)
+{
+    if (mPersistent.IsEmpty())
+        return;
+
+    HandleScope scope(isolate);
+    Local<Object>::New(isolate, mPersistent)->SetInternalField(0, v8::Undefined(isolate));
+    mPersistent.ClearWeak<void>();
+    mPersistent.Reset();
+    if (mExternalSize != 0)
+    {
+        JavascriptContext::GetCurrent()->AdjustExternalMemory(-mExternalSize);
+        mExternalSize = 0;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void
+JavascriptExternal::SetObjectHandleWeak(bool weak)
+{
+    System::Runtime::InteropServices::GCHandle old = System::Runtime::InteropServices::GCHandle::FromIntPtr(mObjectHandle);
+    System::Object^ object = old.Target;
+    if (object == nullptr)
+        return;  // Collected while the handle was weak
+    System::Runtime::InteropServices::GCHandle handle = System::Runtime::InteropServices::GCHandle::Alloc(object, weak ? System::Runtime::InteropServices::GCHandleType::Weak : System::Runtime::InteropServices::GCHandleType::Normal);
+    old.Free();
+    mObjectHandle = System::Runtime::InteropServices::GCHandle::ToIntPtr(handle);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 System::Object^
 JavascriptExternal::GetObject()
 {
@@ -132,28 +187,30 @@ JavascriptExternal::GetObject()
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 Local<Function>
-JavascriptExternal::GetMethod(wstring iName)
+JavascriptExternal::GetMethod(System::String^ iName)
 {
     auto context = JavascriptContext::GetCurrent();
     auto isolate = JavascriptContext::GetCurrentIsolate();
 
     auto type = GetObject()->GetType();
-    auto memberName = gcnew System::String(iName.c_str());
-    auto uniqueMethodName = type->AssemblyQualifiedName + L"." + memberName;
+    auto uniqueMethodName = type->AssemblyQualifiedName + L"." + iName;
 
     if (context->mMethods->ContainsKey(uniqueMethodName))
         return Local<Function>::New(isolate, *context->mMethods[uniqueMethodName].Pointer);
 	
     // Verification if it is a method
-    auto members = type->GetMember(memberName);
+    auto members = type->GetMember(iName);
     if (members->Length > 0 && members[0]->MemberType == MemberTypes::Method)
     {
-        // Store both the method name AND the target object wrapper in function data
+        // Store both the method name AND the target object in function data
         // This ensures we can find the correct object even when called from different contexts
-        auto externalPtr = External::New(isolate, this);
+        // The function is shared by every object of the type and outlives this wrapper, so it
+        // only records the object, weakly; the Invoker looks up its current wrapper.
+        int target = context->mMethodTargets->Count;
+        context->mMethodTargets->Add(gcnew System::WeakReference(GetObject()));
         auto dataArray = v8::Array::New(isolate, 2);
-        dataArray->Set(isolate->GetCurrentContext(), 0, JavascriptInterop::ConvertToV8(memberName)).ToChecked();
-        dataArray->Set(isolate->GetCurrentContext(), 1, externalPtr).ToChecked();
+        dataArray->Set(isolate->GetCurrentContext(), 0, JavascriptInterop::ConvertToV8(iName)).ToChecked();
+        dataArray->Set(isolate->GetCurrentContext(), 1, v8::Int32::New(isolate, target)).ToChecked();
         
         auto functionTemplate = FunctionTemplate::New(isolate, JavascriptInterop::Invoker, dataArray);
         auto function = functionTemplate->GetFunction(isolate->GetCurrentContext()).ToLocalChecked();
@@ -170,7 +227,7 @@ JavascriptExternal::GetMethod(wstring iName)
 Local<Function>
 JavascriptExternal::GetMethod(Local<String> iName)
 {
-	return GetMethod((wchar_t*) *String::Value(JavascriptContext::GetCurrentIsolate(), iName));
+	return GetMethod(JavascriptInterop::ConvertStringFromV8(iName));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -178,11 +235,11 @@ JavascriptExternal::GetMethod(Local<String> iName)
 // Returns false is no such property exists, otherwise check 'result'
 // for an empty value (exception) or the value (including null)
 bool
-JavascriptExternal::GetProperty(wstring iName, Local<Value> &result)
+JavascriptExternal::GetProperty(System::String^ iName, Local<Value> &result)
 {
 	System::Object^ self = GetObject();
 	System::Type^ type = self->GetType();
-	PropertyInfo^ propertyInfo = type->GetProperty(gcnew System::String(iName.c_str()));
+	PropertyInfo^ propertyInfo = type->GetProperty(iName);
 
 	v8::Isolate *isolate = JavascriptContext::GetCurrentIsolate();
 	try
@@ -197,18 +254,18 @@ JavascriptExternal::GetProperty(wstring iName, Local<Value> &result)
 			}
 			if (!indexerInfo->CanRead)
 			{
-				result = isolate->ThrowException(JavascriptInterop::ConvertToV8("Property " + gcnew System::String(iName.c_str()) + " may not be read."));
+				result = isolate->ThrowException(JavascriptInterop::ConvertToV8("Property " + iName + " may not be read."));
 			}
 			else
 			{
-				result = JavascriptInterop::ConvertToV8(indexerInfo->GetValue(self, gcnew cli::array<System::String^> { gcnew System::String(iName.c_str()) }));
+				result = JavascriptInterop::ConvertToV8(indexerInfo->GetValue(self, gcnew cli::array<System::String^> { iName }));
 			}
 			return true;
 		}
 
 		if (!propertyInfo->CanRead)
 		{
-			result = isolate->ThrowException(JavascriptInterop::ConvertToV8("Property " + gcnew System::String(iName.c_str()) + " may not be read."));
+			result = isolate->ThrowException(JavascriptInterop::ConvertToV8("Property " + iName + " may not be read."));
 		}
 		else
 		{
@@ -274,11 +331,11 @@ JavascriptExternal::GetProperty(uint32_t iIndex)
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 Local<Value>
-JavascriptExternal::SetProperty(wstring iName, Local<Value> iValue)
+JavascriptExternal::SetProperty(System::String^ iName, Local<Value> iValue)
 {
 	System::Object^ self = GetObject();
 	System::Type^ type = self->GetType();
-	PropertyInfo^ propertyInfo = type->GetProperty(gcnew System::String(iName.c_str()));
+	PropertyInfo^ propertyInfo = type->GetProperty(iName);
 
 	v8::Isolate *isolate = JavascriptContext::GetCurrentIsolate();
 
@@ -291,16 +348,16 @@ JavascriptExternal::SetProperty(wstring iName, Local<Value> iValue)
 			if (indexerInfo == nullptr)
 			{
 				if ((mOptions & SetParameterOptions::RejectUnknownProperties) == SetParameterOptions::RejectUnknownProperties)
-					return isolate->ThrowException(JavascriptInterop::ConvertToV8("Unknown member: " + gcnew System::String(iName.c_str())));
+					return isolate->ThrowException(JavascriptInterop::ConvertToV8("Unknown member: " + iName));
 				return Local<Value>();
 			}
 			if (!indexerInfo->CanWrite)
 			{
-				return isolate->ThrowException(JavascriptInterop::ConvertToV8("Property " + gcnew System::String(iName.c_str()) + " may not be set."));
+				return isolate->ThrowException(JavascriptInterop::ConvertToV8("Property " + iName + " may not be set."));
 			}
 			else
 			{
-				indexerInfo->SetValue(self, JavascriptInterop::ConvertFromV8(iValue), gcnew cli::array<System::String^> { gcnew System::String(iName.c_str()) });
+				indexerInfo->SetValue(self, JavascriptInterop::ConvertFromV8(iValue), gcnew cli::array<System::String^> { iName });
 			}
 			return iValue;
 		}
@@ -317,7 +374,7 @@ JavascriptExternal::SetProperty(wstring iName, Local<Value> iValue)
 
 		if (!propertyInfo->CanWrite)
 		{
-			return isolate->ThrowException(JavascriptInterop::ConvertToV8("Property " + gcnew System::String(iName.c_str()) + " may not be set."));
+			return isolate->ThrowException(JavascriptInterop::ConvertToV8("Property " + iName + " may not be set."));
 		}
 		else
 		{
@@ -408,11 +465,15 @@ void JavascriptExternal::IteratorCallback(const v8::FunctionCallbackInfo<Value>&
     auto iterator = ObjectTemplate::New(isolate);
     iterator->SetInternalFieldCount(1);
     auto functionTemplate = FunctionTemplate::New(isolate, JavascriptExternal::IteratorNextCallback);
-    iterator->Set(String::NewFromUtf8(isolate, "next").ToLocalChecked(), functionTemplate);
+    iterator->Set(JavascriptContext::GetCurrent()->GetInternedString("next"), functionTemplate);
     auto iteratorInstance = iterator->NewInstance(isolate->GetCurrentContext()).ToLocalChecked();
 
-    auto internalField = iArgs.This()->GetInternalField(0).As<Value>().As<External>();
-    auto external = (JavascriptExternal*)internalField->Value();
+    auto external = FromObject(iArgs.This());
+    if (external == nullptr)
+    {
+        isolate->ThrowException(JavascriptInterop::ConvertToV8("The .NET object has been released"));
+        return;
+    }
     auto enumerable = (System::Collections::IEnumerable^)external->GetObject();
     auto enumerator = enumerable->GetEnumerator();
 
@@ -427,8 +488,12 @@ void JavascriptExternal::IteratorNextCallback(const v8::FunctionCallbackInfo<Val
 {
     auto isolate = iArgs.GetIsolate();
 
-    auto internalField = iArgs.This()->GetInternalField(0).As<Value>().As<External>();
-    auto external = (JavascriptExternal*)internalField->Value();
+    auto external = FromObject(iArgs.This());
+    if (external == nullptr)
+    {
+        isolate->ThrowException(JavascriptInterop::ConvertToV8("The .NET object has been released"));
+        return;
+    }
     auto enumerator = (System::Collections::IEnumerator^) external->GetObject();
 
     try
@@ -438,9 +503,9 @@ void JavascriptExternal::IteratorNextCallback(const v8::FunctionCallbackInfo<Val
         auto done = !enumerator->MoveNext();
         auto resultTemplate = ObjectTemplate::New(isolate);
         auto result = resultTemplate->NewInstance(isolate->GetCurrentContext()).ToLocalChecked();
-        result->Set(isolate->GetCurrentContext(), String::NewFromUtf8(isolate, "done").ToLocalChecked(), JavascriptInterop::ConvertToV8(done));
+        result->Set(isolate->GetCurrentContext(), JavascriptContext::GetCurrent()->GetInternedString("done"), JavascriptInterop::ConvertToV8(done));
         if (!done)
-            result->Set(isolate->GetCurrentContext(), String::NewFromUtf8(isolate, "value").ToLocalChecked(), JavascriptInterop::ConvertToV8(enumerator->Current));
+            result->Set(isolate->GetCurrentContext(), JavascriptContext::GetCurrent()->GetInternedString("value"), JavascriptInterop::ConvertToV8(enumerator->Current));
         iArgs.GetReturnValue().Set(result);
     }
     catch (System::Exception ^exception)
@@ -456,6 +521,55 @@ void JavascriptExternal::IteratorNextCallback(const v8::FunctionCallbackInfo<Val
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+JavascriptExternalPool::JavascriptExternalPool()
+    : mFreeList(nullptr), mLiveCount(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+JavascriptExternalPool::~JavascriptExternalPool()
+{
+    for (Slot *slab : mSlabs)
+        delete[] slab;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+JavascriptExternal*
+JavascriptExternalPool::New(System::Object^ iObject)
+{
+    if (mFreeList == nullptr)
+    {
+        Slot *slab = new Slot[kSlabSize];
+        mSlabs.push_back(slab);
+        for (size_t i = kSlabSize; i > 0; i--)
+        {
+            slab[i - 1].next = mFreeList;
+            mFreeList = &slab[i - 1];
+        }
+    }
+
+    Slot *slot = mFreeList;
+    mFreeList = slot->next;
+    mLiveCount++;
+    return new (slot->storage) JavascriptExternal(iObject);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void
+JavascriptExternalPool::Delete(JavascriptExternal* iExternal)
+{
+    iExternal->~JavascriptExternal();
+    Slot *slot = reinterpret_cast<Slot *>(iExternal);
+    slot->next = mFreeList;
+    mFreeList = slot;
+    mLiveCount--;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } } // namespace Noesis::Javascript
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
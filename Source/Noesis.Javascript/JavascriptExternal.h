@@ -32,6 +32,7 @@
 
 #include <v8.h>
 #include <gcroot.h>
+#include <vector>
 #include "JavascriptContext.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -72,15 +73,28 @@ public:
 
 	System::Object^ GetObject();
 
-	Local<Function> GetMethod(wstring iName);
+	// Returns the JavascriptExternal of a wrapper object, or null if it was detached.
+	static JavascriptExternal* FromObject(Local<Object> iObject);
+
+	// Cuts our JavaScript object off from us, so that using it throws instead of reaching
+	// this (soon to be deleted) JavascriptExternal.
+	void Detach(Isolate* isolate);
+
+	int64_t GetExternalSize() { return mExternalSize; }
+
+	// Lets .NET collect the object while JavaScript still has its wrapper, or stops it doing so
+	// again.  Used by JavascriptContext::Collect() to find out whether anything else uses it.
+	void SetObjectHandleWeak(bool weak);
+
+	Local<Function> GetMethod(System::String^ iName);
 
 	Local<Function> GetMethod(Local<String> iName);
 
-	bool GetProperty(wstring iName, Local<Value> &result);
+	bool GetProperty(System::String^ iName, Local<Value> &result);
 
 	Local<Value> GetProperty(uint32_t iIndex);
 
-	Local<Value> SetProperty(wstring iName, Local<Value> iValue);
+	Local<Value> SetProperty(System::String^ iName, Local<Value> iValue);
 
 	Local<Value> SetProperty(uint32_t iIndex, Local<Value> iValue);
 
@@ -102,12 +116,55 @@ private:
 
 	SetParameterOptions mOptions;
 
+	// Bytes reported to V8 with AdjustAmountOfExternalAllocatedMemory() while our JavaScript
+	// object exists.
+	int64_t mExternalSize;
+
     void InitializePersistent(Isolate* isolate, Local<Object> object);
 
     static void IteratorCallback(const v8::FunctionCallbackInfo<Value>& iArgs);
     static void IteratorNextCallback(const v8::FunctionCallbackInfo<Value>& iArgs);
 };
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// JavascriptExternalPool
+//
+// Allocates a context's JavascriptExternals from slabs, so that scripts touching many .NET
+// objects don't cost a trip to the heap for each one.  Freed records are reused before a new
+// slab is allocated, and the slabs are only given back when the context is destroyed.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+class JavascriptExternalPool
+{
+public:
+
+	JavascriptExternalPool();
+
+	// Every record must have been deleted by now.
+	~JavascriptExternalPool();
+
+	JavascriptExternal* New(System::Object^ iObject);
+
+	void Delete(JavascriptExternal* iExternal);
+
+	size_t GetLiveCount() { return mLiveCount; }
+
+	size_t GetCapacity() { return mSlabs.size() * kSlabSize; }
+
+private:
+
+	union Slot
+	{
+		Slot *next;
+		alignas(JavascriptExternal) unsigned char storage[sizeof(JavascriptExternal)];
+	};
+
+	static const size_t kSlabSize = 256;
+
+	std::vector<Slot *> mSlabs;
+	Slot *mFreeList;
+	size_t mLiveCount;
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 } } // namespace Noesis::Javascript
@@ -9,41 +9,6 @@ namespace Noesis { namespace Javascript {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// This callback is invoked by V8 when it wants to garbage collect the JavaScript function
-void JavascriptFunctionGCCallback(const WeakCallbackInfo<Persistent<Function>>& data)
-{
-    auto handle = data.GetParameter();
-    
-    // V8 requires THIS EXACT HANDLE to be reset in the first-pass callback
-    handle->Reset();
-    
-    auto context = JavascriptContext::GetCurrent();
-    if (context != nullptr && !context->IsDisposed())
-    {
-        for each (auto kvp in context->mFunctions)
-        {
-            auto wrapper = kvp.Value.Pointer;
-            if (wrapper && wrapper->handle == handle)
-            {
-                // Freeing the weak GCHandle allows .NET to collect the managed JavascriptFunction
-                if (wrapper->managedHandle.IsAllocated)
-                    wrapper->managedHandle.Free();
-                
-                delete wrapper->handle;
-                wrapper->handle = nullptr;
-                
-                delete wrapper;
-                
-                // CRITICAL: Remove from cache dictionary to prevent memory leak!
-                context->mFunctions->Remove(kvp.Key);
-                break;
-            }
-        }
-    }
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
 JavascriptFunction::JavascriptFunction(v8::Local<v8::Object> iFunction, JavascriptContext^ context)
 {
 	if (!iFunction->IsFunction())
@@ -55,76 +20,368 @@ JavascriptFunction::JavascriptFunction(v8::Local<v8::Object> iFunction, Javascri
 	auto isolate = context->GetCurrentIsolate();
 	auto func = Local<Function>::Cast(iFunction);
 	
+	// The handle is strong: V8 can't tell whether .NET still uses the function, so it must not
+	// collect it before the JavascriptFunction has been disposed or finalized.  Collect() finds
+	// the cycles this creates.
 	mFuncHandle = new Persistent<Function>(isolate, func);
-	// SetWeak allows V8 to garbage collect the JavaScript function when it's no longer referenced in JS.
-	// The callback notifies us so we can clean up the managed wrapper and remove it from the cache.
-	// Without this, the V8 function would be kept alive forever, causing a memory leak.
-	mFuncHandle->SetWeak(mFuncHandle, JavascriptFunctionGCCallback, WeakCallbackType::kParameter);
+	mWrapper = new JavascriptFunctionWrapper(mFuncHandle, this);
+	context->mFunctions->Add(System::IntPtr(mWrapper));
+	func->SetPrivate(isolate->GetCurrentContext(), context->GetFunctionWrapperKey(), External::New(isolate, mWrapper));
 	
     mContextHandle = gcnew System::WeakReference(context);
 }
 
 JavascriptFunction::~JavascriptFunction()
 {
-	if (mFuncHandle) 
+	auto context = GetContext();
+	if (mWrapper && context && !context->IsDisposed())
 	{
-		auto context = GetContext();
-		if (context && !context->IsDisposed() && !mFuncHandle->IsEmpty())
-		{
-			JavascriptScope scope(context);
-            auto isolate = context->GetCurrentIsolate();
-            HandleScope handleScope(isolate);
-			int identityHash = mFuncHandle->Get(isolate)->GetIdentityHash();
-			
-			if (context->mFunctions->ContainsKey(identityHash))
-			{
-				mFuncHandle->ClearWeak();
-				mFuncHandle->Reset();
-				delete mFuncHandle;
-				
-				context->mFunctions->Remove(identityHash);
-			}
-		}
-		
-		mFuncHandle = nullptr;
+		JavascriptScope scope(context);
+		// V8 may have collected the function while we were waiting for the lock.
+		if (mWrapper)
+			Release(context, mWrapper);
 	}
+	
+	mWrapper = nullptr;
+	mFuncHandle = nullptr;
 }
 
 JavascriptFunction::!JavascriptFunction()
 {
-    delete this;
+	// Taking the isolate's lock here would hold up every other finalizer while a script runs,
+	// so the context releases the function the next time it is entered.
+	auto context = GetContext();
+	if (mWrapper && context && !context->IsDisposed())
+		context->mPendingReleases->Enqueue(System::ValueTuple<System::IntPtr, long long>(System::IntPtr(mWrapper), System::Diagnostics::Stopwatch::GetTimestamp()));
+	
+	mWrapper = nullptr;
+	mFuncHandle = nullptr;
+}
+
+void JavascriptFunction::Release(JavascriptContext^ context, JavascriptFunctionWrapper *wrapper)
+{
+	if (wrapper->handle)
+	{
+		// Make the function get a new JavascriptFunction next time it is passed to .NET,
+		// unless that has already happened.
+		auto isolate = context->GetCurrentIsolate();
+		HandleScope handleScope(isolate);
+		Local<Context> v8Context = isolate->GetCurrentContext();
+		Local<Function> function = wrapper->handle->Get(isolate);
+		Local<Private> key = context->GetFunctionWrapperKey();
+		Local<Value> stored;
+		if (function->GetPrivate(v8Context, key).ToLocal(&stored) && stored->IsExternal() && stored.As<External>()->Value() == wrapper)
+			function->DeletePrivate(v8Context, key);
+	}
+	context->mFunctions->Remove(System::IntPtr(wrapper));
+	ReleaseWrapper(wrapper);
+}
+
+void JavascriptFunction::ReleaseWrapper(JavascriptFunctionWrapper *wrapper)
+{
+    if (wrapper->handle)
+    {
+        wrapper->handle->Reset();
+        delete wrapper->handle;
+    }
+    if (wrapper->managedHandle.IsAllocated)
+    {
+        // Read once: if it is null, the JavascriptFunction may be queueing the wrapper from its
+        // finalizer, and must not find it detached half way.
+        auto function = safe_cast<JavascriptFunction^>(wrapper->managedHandle.Target);
+        if (function != nullptr)
+        {
+            function->mWrapper = nullptr;
+            function->mFuncHandle = nullptr;
+        }
+        wrapper->managedHandle.Free();
+    }
+    delete wrapper;
 }
 
 System::Object^ JavascriptFunction::Call(... cli::array<System::Object^>^ args)
 {
-    if (!IsAlive())
-        throw gcnew JavascriptException(L"This function's owning JavascriptContext has been disposed");
     if (!args)
         throw gcnew System::ArgumentNullException("args");
-	
+
+    return Invoke(false, nullptr, args, nullptr);
+}
+
+JavascriptFunctionInvoker^ JavascriptFunction::Prepare(... cli::array<System::Type^>^ argTypes)
+{
+    if (!argTypes)
+        throw gcnew System::ArgumentNullException("argTypes");
+
+    return gcnew JavascriptFunctionInvoker(this, argTypes);
+}
+
+// Calls with up to this many arguments keep them on the stack.
+static const int kMaxStackArguments = 8;
+
+static Local<Value> ConvertArgument(Isolate *isolate, System::Object^ value, ArgumentConversion conversion)
+{
+    if (value == nullptr)
+        return JavascriptInterop::ConvertToV8(value);
+
+    switch (conversion)
+    {
+    case ArgumentConversion::Boolean: return v8::Boolean::New(isolate, safe_cast<bool>(value));
+    case ArgumentConversion::Int32: return v8::Int32::New(isolate, safe_cast<int>(value));
+    case ArgumentConversion::UInt32: return v8::Integer::NewFromUnsigned(isolate, safe_cast<unsigned int>(value));
+    case ArgumentConversion::Single: return v8::Number::New(isolate, safe_cast<float>(value));
+    case ArgumentConversion::Double: return v8::Number::New(isolate, safe_cast<double>(value));
+    default: return JavascriptInterop::ConvertToV8(value);
+    }
+}
+
+static void ConvertArguments(Isolate *isolate, cli::array<System::Object^>^ args, cli::array<ArgumentConversion>^ conversions, Local<Value> *argv)
+{
+    for (int i = 0; i < args->Length; i++)
+    {
+        argv[i] = conversions == nullptr ? JavascriptInterop::ConvertToV8(args[i]) : ConvertArgument(isolate, args[i], conversions[i]);
+    }
+}
+
+System::Object^ JavascriptFunction::Invoke(bool hasThis, System::Object^ thisArg, cli::array<System::Object^>^ args, cli::array<ArgumentConversion>^ conversions)
+{
+    if (!IsAlive())
+        throw gcnew JavascriptException(L"This function's owning JavascriptContext has been disposed");
+
     auto context = GetContext();
     JavascriptScope scope(context);
 	v8::Isolate* isolate = context->GetCurrentIsolate();
 	HandleScope handleScope(isolate);
 
-	Local<v8::Object> global = context->GetGlobal();
+	Local<v8::Value> receiver = hasThis ? JavascriptInterop::ConvertToV8(thisArg) : context->GetGlobal().As<v8::Value>();
 
 	int argc = args->Length;
-	Local<v8::Value> *argv = new Local<v8::Value>[argc];
-	for (int i = 0; i < argc; i++)
+	Local<v8::Value> stackArgv[kMaxStackArguments];
+	LocalVector<v8::Value> heapArgv(isolate);
+	Local<v8::Value> *argv = stackArgv;
+	if (argc > kMaxStackArguments)
 	{
-		argv[i] = JavascriptInterop::ConvertToV8(args[i]);
+		heapArgv.resize(argc);
+		argv = heapArgv.data();
 	}
+	ConvertArguments(isolate, args, conversions, argv);
 
+	return CallFunction(isolate, receiver, argc, argv);
+}
+
+System::Object^ JavascriptFunction::CallFunction(v8::Isolate *isolate, Local<v8::Value> receiver, int argc, Local<v8::Value> *argv)
+{
 	TryCatch tryCatch(isolate);
-	MaybeLocal<Value> retVal = mFuncHandle->Get(isolate)->Call(isolate->GetCurrentContext(), global, argc, argv);
+	MaybeLocal<Value> retVal = mFuncHandle->Get(isolate)->Call(isolate->GetCurrentContext(), receiver, argc, argv);
 	if (retVal.IsEmpty())
 		throw gcnew JavascriptException(tryCatch);
 
-	delete [] argv;
 	return JavascriptInterop::ConvertFromV8(retVal.ToLocalChecked());
 }
 
+// The JIT compiles this separately for each value type, leaving only the branch for that type,
+// so primitive arguments never get boxed.
+generic<typename T>
+Local<Value> JavascriptFunction::ConvertTypedArgument(v8::Isolate *isolate, T value)
+{
+    using System::Runtime::CompilerServices::Unsafe;
+
+    if (T::typeid == bool::typeid)
+        return v8::Boolean::New(isolate, Unsafe::As<T, bool>(value));
+    if (T::typeid == int::typeid)
+        return v8::Int32::New(isolate, Unsafe::As<T, int>(value));
+    if (T::typeid == unsigned int::typeid)
+        return v8::Integer::NewFromUnsigned(isolate, Unsafe::As<T, unsigned int>(value));
+    if (T::typeid == float::typeid)
+        return v8::Number::New(isolate, Unsafe::As<T, float>(value));
+    if (T::typeid == double::typeid)
+        return v8::Number::New(isolate, Unsafe::As<T, double>(value));
+    return JavascriptInterop::ConvertToV8(safe_cast<System::Object^>(value));
+}
+
+generic<typename T1>
+System::Object^ JavascriptFunction::Call(T1 arg1)
+{
+    if (!IsAlive())
+        throw gcnew JavascriptException(L"This function's owning JavascriptContext has been disposed");
+
+    auto context = GetContext();
+    JavascriptScope scope(context);
+    v8::Isolate* isolate = context->GetCurrentIsolate();
+    HandleScope handleScope(isolate);
+    Local<v8::Value> argv[] = { ConvertTypedArgument(isolate, arg1) };
+    return CallFunction(isolate, context->GetGlobal(), 1, argv);
+}
+
+generic<typename T1, typename T2>
+System::Object^ JavascriptFunction::Call(T1 arg1, T2 arg2)
+{
+    if (!IsAlive())
+        throw gcnew JavascriptException(L"This function's owning JavascriptContext has been disposed");
+
+    auto context = GetContext();
+    JavascriptScope scope(context);
+    v8::Isolate* isolate = context->GetCurrentIsolate();
+    HandleScope handleScope(isolate);
+    Local<v8::Value> argv[] = { ConvertTypedArgument(isolate, arg1), ConvertTypedArgument(isolate, arg2) };
+    return CallFunction(isolate, context->GetGlobal(), 2, argv);
+}
+
+generic<typename T1, typename T2, typename T3>
+System::Object^ JavascriptFunction::Call(T1 arg1, T2 arg2, T3 arg3)
+{
+    if (!IsAlive())
+        throw gcnew JavascriptException(L"This function's owning JavascriptContext has been disposed");
+
+    auto context = GetContext();
+    JavascriptScope scope(context);
+    v8::Isolate* isolate = context->GetCurrentIsolate();
+    HandleScope handleScope(isolate);
+    Local<v8::Value> argv[] = { ConvertTypedArgument(isolate, arg1), ConvertTypedArgument(isolate, arg2), ConvertTypedArgument(isolate, arg3) };
+    return CallFunction(isolate, context->GetGlobal(), 3, argv);
+}
+
+generic<typename T1, typename T2, typename T3, typename T4>
+System::Object^ JavascriptFunction::Call(T1 arg1, T2 arg2, T3 arg3, T4 arg4)
+{
+    if (!IsAlive())
+        throw gcnew JavascriptException(L"This function's owning JavascriptContext has been disposed");
+
+    auto context = GetContext();
+    JavascriptScope scope(context);
+    v8::Isolate* isolate = context->GetCurrentIsolate();
+    HandleScope handleScope(isolate);
+    Local<v8::Value> argv[] = { ConvertTypedArgument(isolate, arg1), ConvertTypedArgument(isolate, arg2), ConvertTypedArgument(isolate, arg3), ConvertTypedArgument(isolate, arg4) };
+    return CallFunction(isolate, context->GetGlobal(), 4, argv);
+}
+
+// CallMany() releases the handles of this many calls at a time.
+static const int kCallManyChunkSize = 256;
+
+cli::array<JavascriptCallResult>^ JavascriptFunction::CallMany(System::Collections::Generic::IEnumerable<cli::array<System::Object^>^>^ argumentSets)
+{
+    if (!IsAlive())
+        throw gcnew JavascriptException(L"This function's owning JavascriptContext has been disposed");
+    if (!argumentSets)
+        throw gcnew System::ArgumentNullException("argumentSets");
+
+    auto context = GetContext();
+    JavascriptScope scope(context);
+    v8::Isolate* isolate = context->GetCurrentIsolate();
+    // The calls may dispose of this JavascriptFunction, so the function is held here for the
+    // whole batch rather than fetched from mFuncHandle again.
+    HandleScope batchScope(isolate);
+    Local<Function> function = mFuncHandle->Get(isolate);
+    Local<Value> global = context->GetGlobal();
+    TryCatch tryCatch(isolate);
+    auto results = gcnew System::Collections::Generic::List<JavascriptCallResult>();
+    auto enumerator = argumentSets->GetEnumerator();
+    try
+    {
+        bool more = enumerator->MoveNext();
+        while (more)
+        {
+            HandleScope handleScope(isolate);
+            for (int i = 0; i < kCallManyChunkSize && more; i++, more = enumerator->MoveNext())
+                results->Add(CallInBatch(isolate, function, global, tryCatch, enumerator->Current));
+        }
+    }
+    finally
+    {
+        delete enumerator;
+    }
+    return results->ToArray();
+}
+
+cli::array<JavascriptCallResult>^ JavascriptFunction::CallManyColumns(... cli::array<System::Array^>^ columns)
+{
+    if (!IsAlive())
+        throw gcnew JavascriptException(L"This function's owning JavascriptContext has been disposed");
+    if (!columns)
+        throw gcnew System::ArgumentNullException("columns");
+    int count = columns->Length > 0 && columns[0] != nullptr ? columns[0]->Length : 0;
+    for each (System::Array^ column in columns)
+    {
+        if (column == nullptr)
+            throw gcnew System::ArgumentNullException("columns");
+        if (column->Length != count)
+            throw gcnew System::ArgumentException("All columns must have the same length", "columns");
+    }
+
+    auto context = GetContext();
+    JavascriptScope scope(context);
+    v8::Isolate* isolate = context->GetCurrentIsolate();
+    // As in CallMany(), the calls may dispose of this JavascriptFunction.
+    HandleScope batchScope(isolate);
+    Local<Function> function = mFuncHandle->Get(isolate);
+    Local<Value> global = context->GetGlobal();
+    TryCatch tryCatch(isolate);
+    auto results = gcnew cli::array<JavascriptCallResult>(count);
+    auto args = gcnew cli::array<System::Object^>(columns->Length);
+    for (int start = 0; start < count; start += kCallManyChunkSize)
+    {
+        HandleScope handleScope(isolate);
+        int end = System::Math::Min(start + kCallManyChunkSize, count);
+        for (int i = start; i < end; i++)
+        {
+            for (int j = 0; j < columns->Length; j++)
+                args[j] = columns[j]->GetValue(i);
+            results[i] = CallInBatch(isolate, function, global, tryCatch, args);
+        }
+    }
+    return results;
+}
+
+JavascriptCallResult JavascriptFunction::CallInBatch(v8::Isolate *isolate, Local<Function> function, Local<Value> receiver, TryCatch &tryCatch, cli::array<System::Object^>^ args)
+{
+    JavascriptCallResult result;
+    if (!args)
+    {
+        result.mError = gcnew System::ArgumentNullException("args");
+        return result;
+    }
+
+    MaybeLocal<Value> retVal;
+    try
+    {
+        int argc = args->Length;
+        Local<v8::Value> stackArgv[kMaxStackArguments];
+        LocalVector<v8::Value> heapArgv(isolate);
+        Local<v8::Value> *argv = stackArgv;
+        if (argc > kMaxStackArguments)
+        {
+            heapArgv.resize(argc);
+            argv = heapArgv.data();
+        }
+        ConvertArguments(isolate, args, nullptr, argv);
+        retVal = function->Call(isolate->GetCurrentContext(), receiver, argc, argv);
+    }
+    catch (System::Exception^ exception)
+    {
+        result.mError = exception;
+        return result;
+    }
+
+    if (retVal.IsEmpty())
+    {
+        // Termination ends the whole batch.
+        if (!tryCatch.CanContinue())
+            throw gcnew JavascriptException(tryCatch);
+        result.mError = gcnew JavascriptException(tryCatch);
+        tryCatch.Reset();
+        return result;
+    }
+
+    try
+    {
+        result.mValue = JavascriptInterop::ConvertFromV8(retVal.ToLocalChecked());
+    }
+    catch (System::Exception^ exception)
+    {
+        result.mError = exception;
+    }
+    return result;
+}
+
 bool JavascriptFunction::operator==(JavascriptFunction^ func1, JavascriptFunction^ func2)
 {
     if (ReferenceEquals(func1, func2))
@@ -180,6 +437,52 @@ System::String^ JavascriptFunction::ToString()
     return safe_cast<System::String^>(JavascriptInterop::ConvertFromV8(asString.ToLocalChecked()));
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+JavascriptFunctionInvoker::JavascriptFunctionInvoker(JavascriptFunction^ function, cli::array<System::Type^>^ argTypes)
+{
+    mFunction = function;
+    mConversions = gcnew cli::array<ArgumentConversion>(argTypes->Length);
+    for (int i = 0; i < argTypes->Length; i++)
+    {
+        System::Type^ type = argTypes[i];
+        if (type == nullptr)
+            throw gcnew System::ArgumentException("Argument types must not be null", "argTypes");
+        if (type == System::Boolean::typeid)
+            mConversions[i] = ArgumentConversion::Boolean;
+        else if (type == System::Int32::typeid)
+            mConversions[i] = ArgumentConversion::Int32;
+        else if (type == System::UInt32::typeid)
+            mConversions[i] = ArgumentConversion::UInt32;
+        else if (type == System::Single::typeid)
+            mConversions[i] = ArgumentConversion::Single;
+        else if (type == System::Double::typeid)
+            mConversions[i] = ArgumentConversion::Double;
+        else
+            mConversions[i] = ArgumentConversion::Any;
+    }
+}
+
+System::Object^ JavascriptFunctionInvoker::Call(... cli::array<System::Object^>^ args)
+{
+    CheckArguments(args);
+    return mFunction->Invoke(false, nullptr, args, mConversions);
+}
+
+System::Object^ JavascriptFunctionInvoker::CallWithThis(System::Object^ thisArg, ... cli::array<System::Object^>^ args)
+{
+    CheckArguments(args);
+    return mFunction->Invoke(true, thisArg, args, mConversions);
+}
+
+void JavascriptFunctionInvoker::CheckArguments(cli::array<System::Object^>^ args)
+{
+    if (!args)
+        throw gcnew System::ArgumentNullException("args");
+    if (args->Length != mConversions->Length)
+        throw gcnew System::ArgumentException(System::String::Format("Expected {0} arguments but got {1}", mConversions->Length, args->Length), "args");
+}
+
 } } // namespace Noesis::Javascript
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
@@ -14,12 +14,53 @@ namespace Noesis { namespace Javascript {
 
 //////////////////////////////////////////////////////////////////////////
 
+ref class JavascriptFunctionInvoker;
+
+// How JavascriptFunctionInvoker converts an argument to JavaScript.
+enum class ArgumentConversion : unsigned char
+{
+	Any,
+	Boolean,
+	Int32,
+	UInt32,
+	Single,
+	Double
+};
+
+//////////////////////////////////////////////////////////////////////////
+// JavascriptCallResult
+//
+// The outcome of one of the calls made by JavascriptFunction.CallMany().
+//////////////////////////////////////////////////////////////////////////
+public value struct JavascriptCallResult
+{
+public:
+	// What the function returned, or null if the call failed.
+	property System::Object^ Value { System::Object^ get() { return mValue; } }
+
+	// Why the call failed: a JavascriptException if the function threw,
+	// or the exception thrown while converting arguments or the result.
+	property System::Exception^ Error { System::Exception^ get() { return mError; } }
+
+	property bool Succeeded { bool get() { return mError == nullptr; } }
+
+internal:
+	System::Object^ mValue;
+	System::Exception^ mError;
+};
+
 //////////////////////////////////////////////////////////////////////////
 // JavascriptFunction
 //
 // Wraps around a JS function when passed back to C#, allowing it to be
 // called from C#.  Callers must not dispose of their JavascriptContext
 // while they still have references to JavascriptFunctions.
+//
+// The JS function is kept alive until the JavascriptFunction is disposed
+// or finalized.  Neither garbage collector sees references in the other
+// heap, so a .NET object that holds a JavascriptFunction closing over the
+// object's own JS wrapper is only released once JavascriptContext::Collect()
+// has found the cycle.
 //////////////////////////////////////////////////////////////////////////
 public ref class JavascriptFunction
 {
@@ -30,6 +71,33 @@ public:
 
 	System::Object^ Call(... cli::array<System::Object^>^ args);
 
+	// Calls with arguments of static types.  bool, int, unsigned int,
+	// float and double arguments are converted without being boxed.
+	generic<typename T1>
+	System::Object^ Call(T1 arg1);
+
+	generic<typename T1, typename T2>
+	System::Object^ Call(T1 arg1, T2 arg2);
+
+	generic<typename T1, typename T2, typename T3>
+	System::Object^ Call(T1 arg1, T2 arg2, T3 arg3);
+
+	generic<typename T1, typename T2, typename T3, typename T4>
+	System::Object^ Call(T1 arg1, T2 arg2, T3 arg3, T4 arg4);
+
+	// Prepares calls with arguments of the given types, for callers that
+	// call the same function over and over.
+	JavascriptFunctionInvoker^ Prepare(... cli::array<System::Type^>^ argTypes);
+
+	// Calls the function once per set of arguments, entering the context
+	// only once.  A call that fails doesn't stop the others; its error is
+	// reported in its result instead.
+	cli::array<JavascriptCallResult>^ CallMany(System::Collections::Generic::IEnumerable<cli::array<System::Object^>^>^ argumentSets);
+
+	// Like CallMany(), with one array per parameter: the i-th call gets
+	// the i-th element of each array.
+	cli::array<JavascriptCallResult>^ CallManyColumns(... cli::array<System::Array^>^ columns);
+
 	static bool operator== (JavascriptFunction^ func1, JavascriptFunction^ func2);
 	bool Equals(JavascriptFunction^ other);
 	virtual bool Equals(Object^ other) override;
@@ -37,12 +105,59 @@ public:
     virtual System::String^ ToString() override;
 internal:
     v8::Persistent<v8::Function>* mFuncHandle;
+    JavascriptFunctionWrapper* mWrapper;
+
+    // Forgets a wrapper of the given context and frees it.  The context must be entered.
+    static void Release(JavascriptContext^ context, JavascriptFunctionWrapper *wrapper);
+
+    // Frees a wrapper and its handle, detaching the JavascriptFunction (if it is still alive)
+    // so that it can't be called any more.  Does not remove it from its context.
+    static void ReleaseWrapper(JavascriptFunctionWrapper *wrapper);
+
+    System::Object^ Invoke(bool hasThis, System::Object^ thisArg, cli::array<System::Object^>^ args, cli::array<ArgumentConversion>^ conversions);
+
+    // Calls the function with converted arguments.  The context must be entered.
+    System::Object^ CallFunction(v8::Isolate *isolate, v8::Local<v8::Value> receiver, int argc, v8::Local<v8::Value> *argv);
+
+    generic<typename T>
+    static v8::Local<v8::Value> ConvertTypedArgument(v8::Isolate *isolate, T value);
+
+    JavascriptCallResult CallInBatch(v8::Isolate *isolate, v8::Local<v8::Function> function, v8::Local<v8::Value> receiver, v8::TryCatch &tryCatch, cli::array<System::Object^>^ args);
 private:
     System::WeakReference^ mContextHandle;
     inline JavascriptContext^ GetContext() { return mContextHandle->IsAlive ? safe_cast<JavascriptContext^>(mContextHandle->Target) : nullptr; }
     inline bool IsAlive() { auto context = GetContext(); return context != nullptr && !context->IsDisposed() && mFuncHandle != nullptr; }
 };
 
+//////////////////////////////////////////////////////////////////////////
+// JavascriptFunctionInvoker
+//
+// Calls a JavascriptFunction with a fixed number of arguments of known
+// types.  Each argument is converted the way its type was prepared for,
+// without looking up its type first, and arguments are kept on the stack
+// rather than in a new native array.  Callers can reuse one args array
+// for every call.
+//////////////////////////////////////////////////////////////////////////
+public ref class JavascriptFunctionInvoker
+{
+public:
+	// Calls the function with the global object as `this`.
+	System::Object^ Call(... cli::array<System::Object^>^ args);
+
+	System::Object^ CallWithThis(System::Object^ thisArg, ... cli::array<System::Object^>^ args);
+
+	property JavascriptFunction^ Function { JavascriptFunction^ get() { return mFunction; } }
+
+internal:
+	JavascriptFunctionInvoker(JavascriptFunction^ function, cli::array<System::Type^>^ argTypes);
+
+private:
+	void CheckArguments(cli::array<System::Object^>^ args);
+
+	JavascriptFunction^ mFunction;
+	cli::array<ArgumentConversion>^ mConversions;
+};
+
 //////////////////////////////////////////////////////////////////////////
 
 } } // namespace Noesis::Javascript
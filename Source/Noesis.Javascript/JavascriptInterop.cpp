@@ -31,11 +31,18 @@
 #include "JavascriptInterop.h"
 
 #include "SystemInterop.h"
+#include "JavascriptArrayBuffer.h"
+#include "JavascriptWasmModule.h"
 #include "JavascriptException.h"
 #include "JavascriptExternal.h"
 #include "JavascriptFunction.h"
 
+#include <cmath>
+#include <cstring>
 #include <string>
+#if defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -112,32 +119,20 @@ JavascriptFunction^
 JavascriptInterop::ConvertFunctionFromV8(Local<Value> iValue)
 {
 	auto context = JavascriptContext::GetCurrent();
+	auto isolate = context->GetCurrentIsolate();
 	auto func = Local<Function>::Cast(iValue);
-	int identityHash = func->GetIdentityHash();
 	
-	// Check if we already have a wrapper for this function
-	if (context->mFunctions->ContainsKey(identityHash))
+	// Reuse the JavascriptFunction this function already has, if it is still alive
+	Local<Value> stored;
+	if (func->GetPrivate(isolate->GetCurrentContext(), context->GetFunctionWrapperKey()).ToLocal(&stored) && stored->IsExternal())
 	{
-		auto wrapped = context->mFunctions[identityHash];
-		auto wrapper = wrapped.Pointer;
-		if (wrapper && wrapper->managedHandle.IsAllocated)
-		{
-			auto target = wrapper->managedHandle.Target;
-			if (target != nullptr)
-				return safe_cast<JavascriptFunction^>(target);  // Reuse existing wrapper
-		}
-		// Stale entry (GC collected), remove it
-		context->mFunctions->Remove(identityHash);
+		auto wrapper = (JavascriptFunctionWrapper *)stored.As<External>()->Value();
+		auto target = wrapper->managedHandle.Target;
+		if (target != nullptr)
+			return safe_cast<JavascriptFunction^>(target);
 	}
 	
-	// Create new wrapper and add to cache
-	auto jsFunc = gcnew JavascriptFunction(
-		iValue->ToObject(context->GetCurrentIsolate()->GetCurrentContext()).ToLocalChecked(), 
-		context
-	);
-	auto wrapper = new JavascriptFunctionWrapper(jsFunc->mFuncHandle, jsFunc);
-	context->mFunctions[identityHash] = WrappedJavascriptFunction(wrapper);
-	return jsFunc;
+	return gcnew JavascriptFunction(func, context);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -151,6 +146,156 @@ JavascriptInterop::ConvertFromV8(Local<Value> iValue)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Strings up to this length are read from V8 into a buffer on the stack.
+static const int kMaxStackStringLength = 256;
+
+System::String^
+JavascriptInterop::ConvertStringFromV8(Local<String> iValue)
+{
+	int length = iValue->Length();
+	if (length == 0)
+		return System::String::Empty;
+
+	// V8 writes (and widens one-byte strings) straight into the characters.  Passing the length
+	// keeps embedded zeros.
+	Isolate *isolate = JavascriptContext::GetCurrentIsolate();
+	if (length <= kMaxStackStringLength)
+	{
+		wchar_t buffer[kMaxStackStringLength];
+		iValue->Write(isolate, (uint16_t *)buffer, 0, length, String::NO_NULL_TERMINATION);
+		return gcnew System::String(buffer, 0, length);
+	}
+
+	// Longer strings are written into a .NET string that nothing else can see yet, the same way
+	// String.Create() fills its result, so that large documents are only copied once.  A non-empty
+	// string created from a repeated character is always a new object.
+	System::String^ result = gcnew System::String(L'\0', length);
+	{
+		pin_ptr<const wchar_t> resultPtr = PtrToStringChars(result);
+		iValue->Write(isolate, (uint16_t *)const_cast<wchar_t *>((const wchar_t *)resultPtr), 0, length, String::NO_NULL_TERMINATION);
+	}
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma managed(push, off)
+// String resource over the characters of a pinned .NET string.  V8 disposes of it once it has
+// collected the string, and `release` then unpins the .NET string.
+class PinnedStringResource: public v8::String::ExternalStringResource
+{
+public:
+	PinnedStringResource(const uint16_t *data, size_t length, void *handle, v8::BackingStore::DeleterCallback release)
+		: mData(data), mLength(length), mHandle(handle), mRelease(release) {}
+
+	const uint16_t *data() const override { return mData; }
+
+	size_t length() const override { return mLength; }
+
+protected:
+	void Dispose() override
+	{
+		mRelease((void *)mData, mLength * sizeof(uint16_t), mHandle);
+		delete this;
+	}
+
+private:
+	const uint16_t *mData;
+	size_t mLength;
+	void *mHandle;
+	v8::BackingStore::DeleterCallback mRelease;
+};
+
+// One-byte string resource over a native copy of a Latin-1 .NET string.
+class Latin1StringResource: public v8::String::ExternalOneByteStringResource
+{
+public:
+	Latin1StringResource(char *data, size_t length) : mData(data), mLength(length) {}
+
+	~Latin1StringResource() override { delete[] mData; }
+
+	const char *data() const override { return mData; }
+
+	size_t length() const override { return mLength; }
+
+private:
+	char *mData;
+	size_t mLength;
+};
+
+// Copies the low bytes of `chars` into `result`, 16 characters at a time where SSE2 is available.
+// Returns false as soon as it finds a character above U+00FF, which V8 can't store in a one-byte
+// string.
+static bool TryNarrowToLatin1(const uint16_t *chars, size_t length, char *result)
+{
+	size_t i = 0;
+#if defined(_M_X64) || defined(_M_IX86)
+	const __m128i highBytes = _mm_set1_epi16((short)0xFF00);
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= length; i += 16)
+	{
+		__m128i low = _mm_loadu_si128((const __m128i *)(chars + i));
+		__m128i high = _mm_loadu_si128((const __m128i *)(chars + i + 8));
+		__m128i outside = _mm_and_si128(_mm_or_si128(low, high), highBytes);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(outside, zero)) != 0xFFFF)
+			return false;
+		_mm_storeu_si128((__m128i *)(result + i), _mm_packus_epi16(low, high));
+	}
+#endif
+	for (; i < length; i++)
+	{
+		if (chars[i] > 0xFF)
+			return false;
+		result[i] = (char)chars[i];
+	}
+	return true;
+}
+#pragma managed(pop)
+
+// Unpins .NET memory that V8 has been using directly, for backing stores and external strings.
+// V8 calls it, possibly on a background thread, once it has collected everything using the memory.
+static void ReleasePinnedBuffer(void *data, size_t length, void *deleter_data)
+{
+	System::Runtime::InteropServices::GCHandle handle = System::Runtime::InteropServices::GCHandle::FromIntPtr(System::IntPtr(deleter_data));
+	System::IDisposable^ memoryHandle = dynamic_cast<System::IDisposable^>(handle.Target);
+	handle.Free();
+	if (memoryHandle != nullptr)
+		memoryHandle->Dispose();
+}
+
+Local<String>
+JavascriptInterop::ConvertStringToV8(System::String^ iString)
+{
+	v8::Isolate *isolate = JavascriptContext::GetCurrentIsolate();
+	int length = iString->Length;
+	int externalStringThreshold = JavascriptContext::GetCurrent()->mExternalStringThreshold;
+
+	if (externalStringThreshold > 0 && length >= externalStringThreshold && length <= String::kMaxLength)
+	{
+		// Latin-1 text takes half the memory as a one-byte string, and then doesn't need to stay pinned.
+		{
+			pin_ptr<const wchar_t> valuePtr = PtrToStringChars(iString);
+			char *latin1 = new char[length];
+			if (TryNarrowToLatin1((const uint16_t *)valuePtr, length, latin1))
+				return String::NewExternalOneByte(isolate, new Latin1StringResource(latin1, length)).ToLocalChecked();
+			delete[] latin1;
+		}
+
+		System::Runtime::InteropServices::GCHandle handle = System::Runtime::InteropServices::GCHandle::Alloc(iString, System::Runtime::InteropServices::GCHandleType::Pinned);
+		PinnedStringResource *resource = new PinnedStringResource((const uint16_t *)handle.AddrOfPinnedObject().ToPointer(), length,
+			System::Runtime::InteropServices::GCHandle::ToIntPtr(handle).ToPointer(), ReleasePinnedBuffer);
+		return String::NewExternalTwoByte(isolate, resource).ToLocalChecked();
+	}
+
+	pin_ptr<const wchar_t> valuePtr = PtrToStringChars(iString);
+
+	// V8 checks for Latin-1 itself and narrows such strings into one-byte strings while copying.
+	// Using a constructor which takes a length makes sure that we don't discard zero bytes in the middle of the string
+	return String::NewFromTwoByte(isolate, (const uint16_t *)valuePtr, v8::NewStringType::kNormal, length).ToLocalChecked();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 System::Object^
 JavascriptInterop::ConvertFromV8(Local<Value> iValue, ConvertedObjects &already_converted)
 {
@@ -163,14 +308,7 @@ JavascriptInterop::ConvertFromV8(Local<Value> iValue, ConvertedObjects &already_
 	if (iValue->IsNumber())
 		return gcnew System::Double(iValue->NumberValue(JavascriptContext::GetCurrentIsolate()->GetCurrentContext()).ToChecked());
     if (iValue->IsString())
-    {
-        auto stringValue = iValue->ToString(JavascriptContext::GetCurrentIsolate()->GetCurrentContext()).ToLocalChecked();
-        auto length = stringValue->Length();
-        String::Value utf16Bytes(JavascriptContext::GetCurrentIsolate(), stringValue);
-        
-        // Using a constructor which takes a length makes sure that we don't discard zero bytes in the middle of the string
-        return gcnew System::String((wchar_t*)* utf16Bytes, 0, length);
-    }
+        return ConvertStringFromV8(iValue.As<String>());
 	if (iValue->IsArray())
 		return ConvertArrayFromV8(iValue, already_converted);
 	if (iValue->IsDate())
@@ -180,10 +318,11 @@ JavascriptInterop::ConvertFromV8(Local<Value> iValue, ConvertedObjects &already_
 	if (iValue->IsFunction())
 		return ConvertFunctionFromV8(iValue);
     if (iValue->IsBigInt())
-    {
-        auto stringRepresentation = iValue->ToString(JavascriptContext::GetCurrentIsolate()->GetCurrentContext()).ToLocalChecked();
-        return System::Numerics::BigInteger::Parse(safe_cast<System::String^>(JavascriptInterop::ConvertFromV8(stringRepresentation, already_converted)));
-    }
+        return ConvertBigIntFromV8(iValue.As<BigInt>());
+    if (iValue->IsArrayBuffer() || iValue->IsSharedArrayBuffer() || iValue->IsArrayBufferView())
+        return gcnew JavascriptArrayBuffer(iValue);
+    if (iValue->IsWasmModuleObject())
+        return gcnew JavascriptWasmModule(iValue.As<WasmModuleObject>()->GetCompiledModule());
 	if (iValue->IsObject())
 	{
 		Local<Object> object = iValue->ToObject(JavascriptContext::GetCurrentIsolate()->GetCurrentContext()).ToLocalChecked();
@@ -199,6 +338,10 @@ JavascriptInterop::ConvertFromV8(Local<Value> iValue, ConvertedObjects &already_
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Dictionary keys up to this length are assumed to come up again and again, and go through the
+// context's string cache.
+static const int kMaxInternedStringLength = 32;
+
 Local<Value>
 JavascriptInterop::ConvertToV8(System::Object^ iObject)
 {
@@ -218,18 +361,11 @@ JavascriptInterop::ConvertToV8(System::Object^ iObject)
 			if (type == System::Boolean::typeid)
 				return v8::Boolean::New(isolate, safe_cast<bool>(iObject));
             if (type == System::Numerics::BigInteger::typeid)
-            {
-                auto globalObj = isolate->GetCurrentContext()->Global();
-                auto bigIntFunction = Local<Function>::Cast(globalObj->Get(context, String::NewFromUtf8(isolate, "BigInt").ToLocalChecked()).ToLocalChecked());
-                Local<Value> parameters[] = { ConvertToV8(safe_cast<System::Numerics::BigInteger>(iObject).ToString()) };
-                return bigIntFunction->Call(isolate->GetCurrentContext(), globalObj, 1, parameters).ToLocalChecked();
-            }
+                return ConvertBigIntegerToV8(safe_cast<System::Numerics::BigInteger>(iObject));
 			if (type->IsEnum)
 			{
 				// No equivalent to enum, so convert to a string.
-				pin_ptr<const wchar_t> valuePtr = PtrToStringChars(iObject->ToString());
-				wchar_t* value = (wchar_t*) valuePtr;
-				return v8::String::NewFromTwoByte(isolate, (uint16_t*)value, v8::NewStringType::kNormal).ToLocalChecked();
+				return JavascriptContext::GetCurrent()->GetInternedString(iObject->ToString());
 			}
 			else
 			{
@@ -258,20 +394,27 @@ JavascriptInterop::ConvertToV8(System::Object^ iObject)
 					return v8::Number::New(isolate, (double)safe_cast<System::Decimal>(iObject));
                 if (type == System::DateTime::typeid)
                     return ConvertDateTimeToV8(safe_cast<System::DateTime^>(iObject));
+				if (type->IsGenericType)
+				{
+					System::Type^ elementType = GetTypedArrayElementType(type);
+					if (elementType != nullptr)
+						return ConvertToTypedArray(iObject, elementType);
+				}
 			}
 		}
 		if (type == System::String::typeid)
-		{
-            auto stringValue = safe_cast<System::String^>(iObject);
-            auto length = stringValue->Length;
-			pin_ptr<const wchar_t> valuePtr = PtrToStringChars(stringValue);
-			wchar_t* value = (wchar_t*) valuePtr;
-
-            // Using a constructor which takes a length makes sure that we don't discard zero bytes in the middle of the string
-			return v8::String::NewFromTwoByte(isolate, (uint16_t*)value, v8::NewStringType::kNormal, length).ToLocalChecked();
-		}
+            return ConvertStringToV8(safe_cast<System::String^>(iObject));
 		if (type->IsArray)
+		{
+			System::Type^ elementType = GetTypedArrayElementType(type);
+			if (elementType != nullptr)
+				return ConvertToTypedArray(iObject, elementType);
 			return ConvertFromSystemArray(safe_cast<System::Array^>(iObject));
+		}
+        if (type == JavascriptArrayBuffer::typeid)
+            return safe_cast<JavascriptArrayBuffer^>(iObject)->ToV8(isolate);
+        if (type == JavascriptWasmModule::typeid)
+            return safe_cast<JavascriptWasmModule^>(iObject)->ToV8(isolate);
         if (type == System::Text::RegularExpressions::Regex::typeid)
             return ConvertFromSystemRegex(safe_cast<System::Text::RegularExpressions::Regex^>(iObject));
 		if (System::Delegate::typeid->IsAssignableFrom(type))
@@ -307,7 +450,7 @@ JavascriptInterop::ConvertToV8(System::Object^ iObject)
 			wchar_t* value = (wchar_t*)valuePtr;
 			Local<v8::Value> error = v8::Exception::Error(v8::String::NewFromTwoByte(isolate, (uint16_t*)value, v8::NewStringType::kNormal).ToLocalChecked());
 			Local<v8::Object> error_o = v8::Local<v8::Object>::Cast(error);
-			Local<String> key = v8::String::NewFromUtf8(isolate, "InnerException", v8::NewStringType::kNormal).ToLocalChecked();
+			Local<String> key = JavascriptContext::GetCurrent()->GetInternedString("InnerException");
 			error_o->Set(isolate->GetCurrentContext(), key, WrapObject(iObject)).ToChecked();
 			return error_o;
 		}
@@ -355,9 +498,8 @@ JavascriptInterop::UnwrapObject(Local<Value> iValue)
 
 		if (object->InternalFieldCount() > 0)
 		{
-			Local<External> external = object->GetInternalField(0).As<Value>().As<External>();
-			JavascriptExternal* wrapper = (JavascriptExternal*) external->Value();
-			return wrapper->GetObject();
+			JavascriptExternal* wrapper = JavascriptExternal::FromObject(object);
+			return wrapper != nullptr ? wrapper->GetObject() : nullptr;
 		}
 	}
 
@@ -437,71 +579,152 @@ JavascriptInterop::ConvertObjectFromV8(Local<Object> iObject, ConvertedObjects &
  * The same problem exists in the other direction.
  *
  * We therefore construct date objects directly from the date components we get from V8 and vice versa.
+ *
+ * Towards .NET we don't need the individual getters for that: getTimezoneOffset() returns exactly the
+ * offset V8 applies when computing getFullYear(), getMonth(), ... for that instant, so shifting the
+ * UTC time value by it gives the local components with a single call.
  */
 
-double GetDateComponent(Isolate* isolate, Local<Date> date, const char* component)
-{
-    auto context = isolate->GetCurrentContext();
-    auto getComponent = date->Get(context, String::NewFromUtf8(isolate, component).ToLocalChecked()).ToLocalChecked().As<Function>();
-    auto componentValue = getComponent->Call(context, date, 0, nullptr).ToLocalChecked();
-    return componentValue->NumberValue(isolate->GetCurrentContext()).ToChecked();
-}
-
 System::DateTime^ JavascriptInterop::ConvertDateFromV8(Local<Date> date)
 {
     auto isolate = JavascriptContext::GetCurrentIsolate();
-    int year = static_cast<int>(GetDateComponent(isolate, date, "getFullYear"));
-    int month = static_cast<int>(GetDateComponent(isolate, date, "getMonth") + 1);
-    int day = static_cast<int>(GetDateComponent(isolate, date, "getDate"));
-    int hour = static_cast<int>(GetDateComponent(isolate, date, "getHours"));
-    int minute = static_cast<int>(GetDateComponent(isolate, date, "getMinutes"));
-    int second = static_cast<int>(GetDateComponent(isolate, date, "getSeconds"));
-    int millisecond = static_cast<int>(GetDateComponent(isolate, date, "getMilliseconds"));
-    return gcnew System::DateTime(year, month, day, hour, minute, second, millisecond, System::DateTimeKind::Local);
+    auto context = isolate->GetCurrentContext();
+
+    double time = date->ValueOf();
+    if (std::isnan(time))
+        throw gcnew System::ArgumentOutOfRangeException("date", "Invalid Date cannot be converted to a DateTime.");
+
+    auto getTimezoneOffset = JavascriptContext::GetCurrent()->GetDateTimezoneOffsetFunction();
+    double offsetMinutes = getTimezoneOffset->Call(context, date, 0, nullptr).ToLocalChecked()->NumberValue(context).ToChecked();
+
+    // Offsets from before standardized time zones are not whole minutes (e.g. +00:53:28 LMT).
+    long long localMilliseconds = static_cast<long long>(time) - llround(offsetMinutes * 60000.0);
+
+    // JavaScript dates reach further than DateTime, so check before the multiplication can overflow.
+    long long epochTicks = System::DateTime::UnixEpoch.Ticks;
+    if (localMilliseconds < (System::DateTime::MinValue.Ticks - epochTicks) / System::TimeSpan::TicksPerMillisecond ||
+        localMilliseconds > (System::DateTime::MaxValue.Ticks - epochTicks) / System::TimeSpan::TicksPerMillisecond)
+        throw gcnew System::ArgumentOutOfRangeException("date", "The date is outside the range supported by DateTime.");
+
+    return gcnew System::DateTime(epochTicks + localMilliseconds * System::TimeSpan::TicksPerMillisecond, System::DateTimeKind::Local);
 }
 
 Local<Date> JavascriptInterop::ConvertDateTimeToV8(System::DateTime^ dateTime)
 {
     auto isolate = JavascriptContext::GetCurrentIsolate();
+    auto context = isolate->GetCurrentContext();
     EscapableHandleScope handleScope(isolate);
 
     if (dateTime->Kind == System::DateTimeKind::Utc)
-        return handleScope.Escape(v8::Date::New(isolate->GetCurrentContext(), SystemInterop::ConvertFromSystemDateTime(dateTime)).ToLocalChecked().As<Date>());
+        return handleScope.Escape(v8::Date::New(context, SystemInterop::ConvertFromSystemDateTime(dateTime)).ToLocalChecked().As<Date>());
+
+    Local<Value> parameters[] = {
+        v8::Int32::New(isolate, dateTime->Year),
+        v8::Int32::New(isolate, dateTime->Month - 1),
+        v8::Int32::New(isolate, dateTime->Day),
+        v8::Int32::New(isolate, dateTime->Hour),
+        v8::Int32::New(isolate, dateTime->Minute),
+        v8::Int32::New(isolate, dateTime->Second),
+        v8::Int32::New(isolate, dateTime->Millisecond)
+    };
+    auto dateConstructor = JavascriptContext::GetCurrent()->GetDateConstructor();
+
+    return handleScope.Escape(dateConstructor->NewInstance(context, 7, parameters).ToLocalChecked().As<Date>());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Both sides store a sign and a little-endian magnitude, so we copy the 64-bit words across
+// instead of formatting and parsing decimal strings.
+System::Numerics::BigInteger^
+JavascriptInterop::ConvertBigIntFromV8(Local<BigInt> iValue)
+{
+    bool lossless;
+    long long value = iValue->Int64Value(&lossless);
+    if (lossless)
+        return gcnew System::Numerics::BigInteger(value);
+
+    int signBit;
+    int wordCount = iValue->WordCount();
+    // The extra zero byte at the end stops BigInteger from reading the magnitude as two's complement.
+    cli::array<unsigned char>^ bytes = gcnew cli::array<unsigned char>(wordCount * sizeof(uint64_t) + 1);
+    {
+        pin_ptr<unsigned char> data = &bytes[0];
+        iValue->ToWordsArray(&signBit, &wordCount, reinterpret_cast<uint64_t*>(data));
+    }
+
+    System::Numerics::BigInteger magnitude(bytes);
+    return gcnew System::Numerics::BigInteger(signBit ? System::Numerics::BigInteger::Negate(magnitude) : magnitude);
+}
 
-    auto year = JavascriptInterop::ConvertToV8(dateTime->Year);
-    auto month = JavascriptInterop::ConvertToV8(dateTime->Month - 1);
-    auto day = JavascriptInterop::ConvertToV8(dateTime->Day);
-    auto hour = JavascriptInterop::ConvertToV8(dateTime->Hour);
-    auto minute = JavascriptInterop::ConvertToV8(dateTime->Minute);
-    auto second = JavascriptInterop::ConvertToV8(dateTime->Second);
-    auto millisecond = JavascriptInterop::ConvertToV8(dateTime->Millisecond);
+Local<BigInt>
+JavascriptInterop::ConvertBigIntegerToV8(System::Numerics::BigInteger iValue)
+{
+    auto isolate = JavascriptContext::GetCurrentIsolate();
+    if (iValue.GetBitLength() < 64)
+        return BigInt::New(isolate, (long long)iValue);
 
-    auto globalObj = isolate->GetCurrentContext()->Global();
-    auto dateConstructor = Local<Function>::Cast(globalObj->Get(isolate->GetCurrentContext(), String::NewFromUtf8(isolate, "Date").ToLocalChecked()).ToLocalChecked());
-    Local<Value> parameters[] = { year, month, day, hour, minute, second, millisecond };
+    cli::array<unsigned char>^ bytes = System::Numerics::BigInteger::Abs(iValue).ToByteArray(true, false);
+    vector<uint64_t> words((bytes->Length + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+    {
+        pin_ptr<unsigned char> data = &bytes[0];
+        memcpy(words.data(), data, bytes->Length);
+    }
 
-    return handleScope.Escape(dateConstructor->NewInstance(isolate->GetCurrentContext(), 7, parameters).ToLocalChecked().As<Date>());
+    int signBit = iValue.Sign < 0 ? 1 : 0;
+    return BigInt::NewFromWords(isolate->GetCurrentContext(), signBit, static_cast<int>(words.size()), words.data()).ToLocalChecked();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Caches never grow beyond this; when full they are simply emptied.
+static const int kMaxCachedRegexes = 256;
+
 System::Text::RegularExpressions::Regex^
 JavascriptInterop::ConvertRegexFromV8(Local<Value> iValue)
 {
     using RegexOptions = System::Text::RegularExpressions::RegexOptions;
 
-    Local<RegExp> regexp = Local<RegExp>::Cast(iValue->ToObject(JavascriptContext::GetCurrentIsolate()->GetCurrentContext()).ToLocalChecked());
+    JavascriptContext^ context = JavascriptContext::GetCurrent();
+    Local<RegExp> regexp = Local<RegExp>::Cast(iValue->ToObject(context->GetCurrentIsolate()->GetCurrentContext()).ToLocalChecked());
     Local<String> jsPattern = regexp->GetSource();
     RegExp::Flags jsFlags = regexp->GetFlags();
 
     System::String^ pattern = safe_cast<System::String^>(ConvertFromV8(jsPattern));
+    System::ValueTuple<System::String^, int> key(pattern, static_cast<int>(jsFlags));
+
+    CachedRegex^ cached;
+    if (context->mRegexCache->TryGetValue(key, cached))
+    {
+        cached->conversions++;
+        if (context->mRegexCompilationThreshold > 0 && cached->conversions == context->mRegexCompilationThreshold)
+        {
+            cached->regex = gcnew System::Text::RegularExpressions::Regex(pattern, cached->regex->Options | RegexOptions::Compiled);
+            JavascriptContext::sRegexFlags->AddOrUpdate(cached->regex, static_cast<int>(jsFlags));
+        }
+        return cached->regex;
+    }
+
+    // .NET has no counterpart to g, s, u and y. Those are remembered in sRegexFlags instead, so
+    // they come back when the Regex is converted to JavaScript again.
     RegexOptions flags = RegexOptions::ECMAScript;
     if (jsFlags & RegExp::Flags::kIgnoreCase)
         flags = flags | RegexOptions::IgnoreCase;
     if (jsFlags & RegExp::Flags::kMultiline)
         flags = flags | RegexOptions::Multiline;
+    if (context->mRegexCompilationThreshold == 1)
+        flags = flags | RegexOptions::Compiled;
+
+    if (context->mRegexCache->Count >= kMaxCachedRegexes)
+        context->mRegexCache->Clear();
+
+    cached = gcnew CachedRegex();
+    cached->regex = gcnew System::Text::RegularExpressions::Regex(pattern, flags);
+    cached->conversions = 1;
+    context->mRegexCache->Add(key, cached);
+    JavascriptContext::sRegexFlags->AddOrUpdate(cached->regex, static_cast<int>(jsFlags));
 
-    return gcnew System::Text::RegularExpressions::Regex(pattern, flags);
+    return cached->regex;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -509,19 +732,184 @@ JavascriptInterop::ConvertRegexFromV8(Local<Value> iValue)
 v8::Local<v8::Value>
 JavascriptInterop::ConvertFromSystemArray(System::Array^ iArray) 
 {
-	int lenght = iArray->Length;
+	int length = iArray->Length;
 	v8::Isolate *isolate = JavascriptContext::GetCurrentIsolate();
-	Local<Context> context = isolate->GetCurrentContext();
-	v8::Local<v8::Array> result = v8::Array::New(isolate);
-	
-	// Transform the .NET array into a Javascript array 
-	for (int i = 0; i < lenght; i++) 
+
+	// Convert all elements first so that V8 can allocate the array at its final size
+	// instead of growing it one Set() at a time.
+	v8::LocalVector<v8::Value> elements(isolate);
+	elements.reserve(length);
+	for (int i = 0; i < length; i++)
+		elements.push_back(ConvertToV8(iArray->GetValue(i)));
+
+	return v8::Array::New(isolate, elements.data(), elements.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A .NET buffer pinned in memory.  `handle` is a GCHandle converted to a pointer: either a
+// pinned handle to an array, or a normal handle to the boxed MemoryHandle doing the pinning.
+// It is null if the buffer is empty.
+struct PinnedBuffer
+{
+	void *data;
+	size_t length;
+	size_t byteLength;
+	void *handle;
+};
+
+template<typename T>
+static void PinArray(array<T>^ values, int offset, int count, PinnedBuffer &buffer)
+{
+	System::Runtime::InteropServices::GCHandle handle = System::Runtime::InteropServices::GCHandle::Alloc(values, System::Runtime::InteropServices::GCHandleType::Pinned);
+	buffer.data = (T *)handle.AddrOfPinnedObject().ToPointer() + offset;
+	buffer.length = count;
+	buffer.byteLength = (size_t)count * sizeof(T);
+	buffer.handle = System::Runtime::InteropServices::GCHandle::ToIntPtr(handle).ToPointer();
+}
+
+template<typename T>
+static void PinMemory(System::Buffers::MemoryHandle pin, int count, PinnedBuffer &buffer)
+{
+	buffer.data = pin.Pointer;
+	buffer.length = count;
+	buffer.byteLength = (size_t)count * sizeof(T);
+	buffer.handle = System::Runtime::InteropServices::GCHandle::ToIntPtr(System::Runtime::InteropServices::GCHandle::Alloc(pin)).ToPointer();
+}
+
+// Pins a T[], ArraySegment<T>, Memory<T> or ReadOnlyMemory<T>.
+template<typename T>
+static void PinBuffer(System::Object^ iObject, System::Type^ type, PinnedBuffer &buffer)
+{
+	buffer.data = nullptr;
+	buffer.length = 0;
+	buffer.byteLength = 0;
+	buffer.handle = nullptr;
+
+	if (type->IsArray)
+	{
+		array<T>^ values = safe_cast<array<T>^>(iObject);
+		if (values->Length > 0)
+			PinArray(values, 0, values->Length, buffer);
+		return;
+	}
+
+	System::Type^ definition = type->GetGenericTypeDefinition();
+	if (definition == System::ArraySegment::typeid)
+	{
+		System::ArraySegment<T> segment = safe_cast<System::ArraySegment<T>>(iObject);
+		if (segment.Count > 0)
+			PinArray(segment.Array, segment.Offset, segment.Count, buffer);
+	}
+	else if (definition == System::Memory::typeid)
+	{
+		System::Memory<T> memory = safe_cast<System::Memory<T>>(iObject);
+		if (memory.Length > 0)
+			PinMemory<T>(memory.Pin(), memory.Length, buffer);
+	}
+	else
 	{
-		v8::Local<v8::Value> key = v8::Int32::New(isolate, i);
-		result->Set(context, key, ConvertToV8(iArray->GetValue(i))).ToChecked();
+		System::ReadOnlyMemory<T> memory = safe_cast<System::ReadOnlyMemory<T>>(iObject);
+		if (memory.Length > 0)
+			PinMemory<T>(memory.Pin(), memory.Length, buffer);
 	}
+}
 
-	return result;
+System::Type^
+JavascriptInterop::GetTypedArrayElementType(System::Type^ type)
+{
+	if (JavascriptContext::GetCurrent()->mPrimitiveArrayConversion == TypedArrayConversion::None)
+		return nullptr;
+
+	System::Type^ elementType;
+	if (type->IsSZArray)
+		elementType = type->GetElementType();
+	else if (type->IsArray)
+		return nullptr;
+	else
+	{
+		System::Type^ definition = type->GetGenericTypeDefinition();
+		if (definition != System::Memory::typeid && definition != System::ReadOnlyMemory::typeid && definition != System::ArraySegment::typeid)
+			return nullptr;
+		elementType = type->GetGenericArguments()[0];
+	}
+
+	// Enums are converted to their names, so arrays of them are no typed arrays.
+	if (elementType->IsEnum)
+		return nullptr;
+
+	switch (System::Type::GetTypeCode(elementType))
+	{
+	case System::TypeCode::Byte:
+	case System::TypeCode::SByte:
+	case System::TypeCode::Int16:
+	case System::TypeCode::UInt16:
+	case System::TypeCode::Int32:
+	case System::TypeCode::UInt32:
+	case System::TypeCode::Int64:
+	case System::TypeCode::UInt64:
+	case System::TypeCode::Single:
+	case System::TypeCode::Double:
+		return elementType;
+	default:
+		return nullptr;
+	}
+}
+
+v8::Local<v8::Value>
+JavascriptInterop::ConvertToTypedArray(System::Object^ iObject, System::Type^ elementType)
+{
+	v8::Isolate *isolate = JavascriptContext::GetCurrentIsolate();
+	System::Type^ type = iObject->GetType();
+	System::TypeCode typeCode = System::Type::GetTypeCode(elementType);
+
+	PinnedBuffer buffer;
+	switch (typeCode)
+	{
+	case System::TypeCode::Byte: PinBuffer<unsigned char>(iObject, type, buffer); break;
+	case System::TypeCode::SByte: PinBuffer<signed char>(iObject, type, buffer); break;
+	case System::TypeCode::Int16: PinBuffer<short>(iObject, type, buffer); break;
+	case System::TypeCode::UInt16: PinBuffer<unsigned short>(iObject, type, buffer); break;
+	case System::TypeCode::Int32: PinBuffer<int>(iObject, type, buffer); break;
+	case System::TypeCode::UInt32: PinBuffer<unsigned int>(iObject, type, buffer); break;
+	case System::TypeCode::Int64: PinBuffer<long long>(iObject, type, buffer); break;
+	case System::TypeCode::UInt64: PinBuffer<unsigned long long>(iObject, type, buffer); break;
+	case System::TypeCode::Single: PinBuffer<float>(iObject, type, buffer); break;
+	default: PinBuffer<double>(iObject, type, buffer); break;
+	}
+
+	Local<ArrayBuffer> arrayBuffer;
+#ifndef V8_ENABLE_SANDBOX
+	// With the sandbox enabled, V8 only accepts backing stores allocated inside of it.
+	if (buffer.handle != nullptr && JavascriptContext::GetCurrent()->mPrimitiveArrayConversion == TypedArrayConversion::Share)
+	{
+		std::shared_ptr<BackingStore> store = ArrayBuffer::NewBackingStore(buffer.data, buffer.byteLength, ReleasePinnedBuffer, buffer.handle);
+		arrayBuffer = ArrayBuffer::New(isolate, store);
+	}
+	else
+#endif
+	{
+		arrayBuffer = ArrayBuffer::New(isolate, buffer.byteLength);
+		if (buffer.handle != nullptr)
+		{
+			memcpy(arrayBuffer->Data(), buffer.data, buffer.byteLength);
+			ReleasePinnedBuffer(buffer.data, buffer.byteLength, buffer.handle);
+		}
+	}
+
+	switch (typeCode)
+	{
+	case System::TypeCode::Byte: return Uint8Array::New(arrayBuffer, 0, buffer.length);
+	case System::TypeCode::SByte: return Int8Array::New(arrayBuffer, 0, buffer.length);
+	case System::TypeCode::Int16: return Int16Array::New(arrayBuffer, 0, buffer.length);
+	case System::TypeCode::UInt16: return Uint16Array::New(arrayBuffer, 0, buffer.length);
+	case System::TypeCode::Int32: return Int32Array::New(arrayBuffer, 0, buffer.length);
+	case System::TypeCode::UInt32: return Uint32Array::New(arrayBuffer, 0, buffer.length);
+	case System::TypeCode::Int64: return BigInt64Array::New(arrayBuffer, 0, buffer.length);
+	case System::TypeCode::UInt64: return BigUint64Array::New(arrayBuffer, 0, buffer.length);
+	case System::TypeCode::Single: return Float32Array::New(arrayBuffer, 0, buffer.length);
+	default: return Float64Array::New(arrayBuffer, 0, buffer.length);
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -533,59 +921,115 @@ JavascriptInterop::ConvertFromSystemRegex(System::Text::RegularExpressions::Rege
     if (!iRegex->Options.HasFlag(RegexOptions::ECMAScript))
         throw gcnew System::Exception("Only regular expressions with the ECMAScript option can be converted.");
 
-    v8::Isolate *isolate = JavascriptContext::GetCurrentIsolate();
-    Local<Context> context = isolate->GetCurrentContext();
+    JavascriptContext^ context = JavascriptContext::GetCurrent();
+    v8::Isolate *isolate = context->GetCurrentIsolate();
+    Local<Context> v8Context = isolate->GetCurrentContext();
 
-    Local<String> pattern = Local<String>::Cast(ConvertToV8(iRegex->ToString()));
     RegExp::Flags flags = RegExp::Flags::kNone;
-    if (iRegex->Options.HasFlag(RegexOptions::IgnoreCase))
-        flags = static_cast<RegExp::Flags>(flags | RegExp::Flags::kIgnoreCase);
-    if (iRegex->Options.HasFlag(RegexOptions::Multiline))
-        flags = static_cast<RegExp::Flags>(flags | RegExp::Flags::kMultiline);
+    System::Object^ jsFlags;
+    if (JavascriptContext::sRegexFlags->TryGetValue(iRegex, jsFlags))
+    {
+        // Originally came from JavaScript, so restore all of its flags.
+        flags = static_cast<RegExp::Flags>(safe_cast<int>(jsFlags));
+    }
+    else
+    {
+        if (iRegex->Options.HasFlag(RegexOptions::IgnoreCase))
+            flags = static_cast<RegExp::Flags>(flags | RegExp::Flags::kIgnoreCase);
+        if (iRegex->Options.HasFlag(RegexOptions::Multiline))
+            flags = static_cast<RegExp::Flags>(flags | RegExp::Flags::kMultiline);
+    }
 
-    return RegExp::New(context, pattern, flags).ToLocalChecked();
+    System::String^ patternString = iRegex->ToString();
+    Local<String> pattern;
+    System::IntPtr cachedPattern;
+    if (context->mRegExpSources->TryGetValue(patternString, cachedPattern))
+    {
+        pattern = ((Persistent<String> *)(void *)cachedPattern)->Get(isolate);
+    }
+    else
+    {
+        if (context->mRegExpSources->Count >= kMaxCachedRegexes)
+            context->ClearRegExpSources();
+
+        pin_ptr<const wchar_t> patternPtr = PtrToStringChars(patternString);
+        pattern = String::NewFromTwoByte(isolate, (uint16_t*)patternPtr, v8::NewStringType::kInternalized, patternString->Length).ToLocalChecked();
+        context->mRegExpSources->Add(patternString, System::IntPtr(new Persistent<String>(isolate, pattern)));
+    }
+
+    return RegExp::New(v8Context, pattern, flags).ToLocalChecked();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Properties added with the API's Set() are keyed stores, for which V8 switches an object to
+// dictionary mode once it has more than 12 (kFastPropertiesSoftLimit) properties outside the 4
+// that a plain object has room for in itself.  Up to that we add the properties one by one, so
+// that dictionaries with the same keys share a hidden class and scripts get fast property access
+// on them.  Beyond it the object would end up in dictionary mode either way.
+static const int kMaxFastDictionaryProperties = 16;
+
 v8::Local<v8::Value>
 JavascriptInterop::ConvertFromSystemDictionary(System::Object^ iObject) 
 {
-	v8::Local<v8::Object> object = v8::Object::New(JavascriptContext::GetCurrentIsolate());
 	System::Collections::IDictionary^ dictionary =  safe_cast<System::Collections::IDictionary^>(iObject);
 	v8::Isolate *isolate = JavascriptContext::GetCurrentIsolate();
 	Local<Context> context = isolate->GetCurrentContext();
+	System::Collections::IDictionaryEnumerator^ entries = dictionary->GetEnumerator();
 
-	for each(System::Object^ keyValue in dictionary->Keys) 
+	if (dictionary->Count <= kMaxFastDictionaryProperties)
 	{
-		v8::Local<v8::Value> key = ConvertToV8(keyValue);
-		v8::Local<v8::Value> val = ConvertToV8(dictionary[keyValue]);
-		object->Set(context, key, val).ToChecked();
-	} 
-
+		v8::Local<v8::Object> object = v8::Object::New(isolate);
+		while (entries->MoveNext())
+			object->Set(context, ConvertKeyToV8(entries->Key), ConvertToV8(entries->Value)).ToChecked();
+		return object;
+	}
 
+	v8::LocalVector<v8::Name> names(isolate);
+	v8::LocalVector<v8::Value> values(isolate);
+	names.reserve(dictionary->Count);
+	values.reserve(dictionary->Count);
+	while (entries->MoveNext())
+	{
+		v8::Local<v8::Value> key = ConvertKeyToV8(entries->Key);
+		if (!key->IsName())
+			key = key->ToString(context).ToLocalChecked();
+		names.push_back(key.As<v8::Name>());
+		values.push_back(ConvertToV8(entries->Value));
+	}
 
-	return object;
+	// Object.prototype, as for any object literal.
+	v8::Local<v8::Value> prototype = v8::Object::New(isolate)->GetPrototype();
+	return v8::Object::New(isolate, prototype, names.data(), values.data(), names.size());
 }	
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Keys, unlike values, are few and used over and over, so short string keys are interned.
+v8::Local<v8::Value>
+JavascriptInterop::ConvertKeyToV8(System::Object^ iKey)
+{
+	System::String^ key = dynamic_cast<System::String^>(iKey);
+	if (key != nullptr && key->Length <= kMaxInternedStringLength)
+		return JavascriptContext::GetCurrent()->GetInternedString(key);
+	return ConvertToV8(iKey);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 v8::Local<v8::Value>
 JavascriptInterop::ConvertFromSystemList(System::Object^ iObject) 
 {
 	auto isolate = JavascriptContext::GetCurrentIsolate();
-	auto context = isolate->GetCurrentContext();
-	v8::Local<v8::Array> object = v8::Array::New(isolate);
 	System::Collections::IList^ list =  safe_cast<System::Collections::IList^>(iObject);
+	int count = list->Count;
 
-	for(int i = 0; i < list->Count; i++) 
-	{
-		v8::Local<v8::Value> key = v8::Int32::New(isolate, i);
-		v8::Local<v8::Value> val = ConvertToV8(list[i]);
-		object->Set(context, key, val);
-	} 
+	v8::LocalVector<v8::Value> elements(isolate);
+	elements.reserve(count);
+	for (int i = 0; i < count; i++)
+		elements.push_back(ConvertToV8(list[i]));
 
-	return object;
+	return v8::Array::New(isolate, elements.data(), elements.size());
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -695,18 +1139,29 @@ JavascriptInterop::IsSystemObject(Local<Value> iValue)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Used by the interceptors of wrappers that were detached when their JavascriptObjectScope ended.
+static Intercepted
+ThrowReleased(Isolate* isolate)
+{
+	isolate->ThrowException(JavascriptInterop::ConvertToV8("The .NET object has been released"));
+	return Intercepted::kYes;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 Intercepted
 JavascriptInterop::Getter(Local<Name> iName, const PropertyCallbackInfo<Value>& iInfo)
 {
     Isolate* isolate = iInfo.GetIsolate();
-	Local<External> external = iInfo.HolderV2()->GetInternalField(0).As<Value>().As<External>();
-	JavascriptExternal* wrapper = (JavascriptExternal*) external->Value();
+	JavascriptExternal* wrapper = JavascriptExternal::FromObject(iInfo.HolderV2());
+	if (wrapper == nullptr)
+		return ThrowReleased(isolate);
 	Local<Function> function;
 	Local<Value> value;
 
     if (iName->IsString())
     {
-        wstring name = (wchar_t*)*String::Value(isolate, iName);
+        System::String^ name = ConvertStringFromV8(iName.As<String>());
 
         // get method
         function = wrapper->GetMethod(name);
@@ -722,9 +1177,9 @@ JavascriptInterop::Getter(Local<Name> iName, const PropertyCallbackInfo<Value>&
         }
 
         // map toString with ToString
-        if (name == L"toString")
+        if (name->Equals("toString"))
         {
-            function = wrapper->GetMethod(L"ToString");
+            function = wrapper->GetMethod("ToString");
             if (!function.IsEmpty()) {
                 iInfo.GetReturnValue().Set(function);
                 return Intercepted::kYes;
@@ -756,9 +1211,10 @@ JavascriptInterop::Getter(Local<Name> iName, const PropertyCallbackInfo<Value>&
 Intercepted
 JavascriptInterop::Setter(Local<String> iName, Local<Value> iValue, const PropertyCallbackInfo<Value>& iInfo)
 {
-	wstring name = (wchar_t*) *String::Value(JavascriptContext::GetCurrentIsolate(), iName);
-	Local<External> external = iInfo.HolderV2()->GetInternalField(0).As<Value>().As<External>();
-	JavascriptExternal* wrapper = (JavascriptExternal*) external->Value();
+	JavascriptExternal* wrapper = JavascriptExternal::FromObject(iInfo.HolderV2());
+	if (wrapper == nullptr)
+		return ThrowReleased(iInfo.GetIsolate());
+	System::String^ name = ConvertStringFromV8(iName);
 
     auto value = wrapper->SetProperty(name, iValue);
     if (!value.IsEmpty())
@@ -773,8 +1229,9 @@ JavascriptInterop::Setter(Local<String> iName, Local<Value> iValue, const Proper
 Intercepted
 JavascriptInterop::IndexGetter(uint32_t iIndex, const PropertyCallbackInfo<Value> &iInfo)
 {
-	Local<External> external = iInfo.HolderV2()->GetInternalField(0).As<Value>().As<External>();
-	JavascriptExternal* wrapper = (JavascriptExternal*) external->Value();
+	JavascriptExternal* wrapper = JavascriptExternal::FromObject(iInfo.HolderV2());
+	if (wrapper == nullptr)
+		return ThrowReleased(iInfo.GetIsolate());
 	Local<Value> value;
 
 	value = wrapper->GetProperty(iIndex);
@@ -791,8 +1248,9 @@ JavascriptInterop::IndexGetter(uint32_t iIndex, const PropertyCallbackInfo<Value
 Intercepted
 JavascriptInterop::IndexSetter(uint32_t iIndex, Local<Value> iValue, const PropertyCallbackInfo<Value> &iInfo)
 {
-	Local<External> external = iInfo.HolderV2()->GetInternalField(0).As<Value>().As<External>();
-	JavascriptExternal* wrapper = (JavascriptExternal*) external->Value();
+	JavascriptExternal* wrapper = JavascriptExternal::FromObject(iInfo.HolderV2());
+	if (wrapper == nullptr)
+		return ThrowReleased(iInfo.GetIsolate());
 	Local<Value> value;
 
 	value = wrapper->SetProperty(iIndex, iValue);
@@ -829,12 +1287,15 @@ int CountMaximumNumberOfParameters(cli::array<System::Reflection::MemberInfo^>^
 //    - This is the common case: obj.method()
 //    - Fast path with direct access to the correct wrapper
 //
-// 2. FALLBACK PATH: Extract wrapper from function data array
+// 2. FALLBACK PATH: Look up the object recorded in the function data array
 //    - Used when This()->InternalFieldCount() == 0
 //    - Happens when calling context obscures the original object:
 //      * with(new Proxy({}, {})) { method() } - This() points to Proxy
 //      * method.call(someOtherContext) - This() may point to non-.NET object
-//    - The wrapper was embedded at function creation time (see JavascriptExternal::GetMethod)
+//    - The data holds an index into the context's mMethodTargets, which weakly references
+//      the object the method was first read from (see JavascriptExternal::GetMethod)
+//    - The object's wrapper is looked up in mExternals, so an object that has been released
+//      or collected is reported as such, instead of reaching a freed or reused wrapper
 //    - Ensures methods work even when V8's execution context separates function from object
 //
 // This allows cached .NET methods to work correctly regardless of JavaScript calling context.
@@ -844,10 +1305,10 @@ JavascriptInterop::Invoker(const v8::FunctionCallbackInfo<Value>& iArgs)
 {
     v8::Isolate* isolate = JavascriptContext::GetCurrentIsolate();
 
-	// Extract method name and fallback wrapper from function data.
+	// Extract method name and fallback target from function data.
     // Function data is an array created in JavascriptExternal::GetMethod():
     //   [0] = method name (String)
-    //   [1] = External pointer to JavascriptExternal wrapper (fallback for when This() fails)
+    //   [1] = index of the fallback target in mMethodTargets (for when This() fails)
 	Local<Value> data = iArgs.Data();
 	if (!data->IsArray()) {
 		isolate->ThrowException(JavascriptInterop::ConvertToV8(
@@ -866,16 +1327,16 @@ JavascriptInterop::Invoker(const v8::FunctionCallbackInfo<Value>& iArgs)
 	}
 	System::String^ memberName = (System::String^) ConvertFromV8(methodNameValue);
 
-	Local<Value> externalValue = dataArray->Get(context, 1).ToLocalChecked();
-	if (!externalValue->IsExternal()) {
+	Local<Value> targetValue = dataArray->Get(context, 1).ToLocalChecked();
+	if (!targetValue->IsInt32()) {
 		System::String^ errorMsg = System::String::Format(
-            "Internal error: wrapper for method '{0}' is not an External",
+            "Internal error: target of method '{0}' is not an index",
             memberName
         );
         isolate->ThrowException(JavascriptInterop::ConvertToV8(errorMsg));
         return;
 	}
-	JavascriptExternal* fallbackExternal = (JavascriptExternal*) Local<External>::Cast(externalValue)->Value();
+	int fallbackTarget = targetValue.As<Int32>()->Value();
     
     // PRIMARY PATH: Try to get wrapper from This() first.
     // This ensures each object uses its own wrapper when possible, which is important for:
@@ -896,38 +1357,36 @@ JavascriptInterop::Invoker(const v8::FunctionCallbackInfo<Value>& iArgs)
             return;
         }
 
-        Local<Value> fieldValue = targetObject->GetInternalField(0).As<Value>();
-        if (!fieldValue->IsExternal()) {
+        external = JavascriptExternal::FromObject(targetObject);
+        if (external == nullptr) {
             isolate->ThrowException(JavascriptInterop::ConvertToV8(
-                System::String::Format("Invalid internal field in This() for method '{0}'", memberName)
+                System::String::Format("Cannot call method '{0}': the .NET object has been released", memberName)
             ));
             return;
         }
-        Local<External> internalField = Local<External>::Cast(fieldValue);
-        external = (JavascriptExternal*)internalField->Value();
     } else {
        // FALLBACK PATH: This()->InternalFieldCount() == 0
        // This happens when the method is called from a context where V8's This() doesn't
        // point to the original .NET object wrapper. Common scenarios:
        //   - with(new Proxy({}, {})) { method() }  - This() is the Proxy
        //   - method.call(null) or method.apply(null) - This() is null/non-.NET object
-       // In these cases, we use the wrapper that was embedded in function data when the
-       // method was first created (see JavascriptExternal::GetMethod)
-       if (fallbackExternal == nullptr) {
-           // CRITICAL ERROR: No wrapper available from either path
-           // This should never happen if functions are created via JavascriptExternal::GetMethod
-           // If we reach here, something is fundamentally wrong with function creation
+       // In these cases, we use the object that was recorded when the method was first
+       // created (see JavascriptExternal::GetMethod), if it still has a wrapper.
+       System::Object^ target = JavascriptContext::GetCurrent()->mMethodTargets[fallbackTarget]->Target;
+       WrappedJavascriptExternal wrapped;
+       if (target == nullptr || !JavascriptContext::GetCurrent()->mExternals->TryGetValue(target, wrapped)) {
            isolate->ThrowException(JavascriptInterop::ConvertToV8(
-               System::String::Format("No wrapper available for method '{0}'", memberName)
+               System::String::Format("Cannot call method '{0}': the .NET object has been released", memberName)
            ));
            return;
        }
-       external = fallbackExternal;
+       external = wrapped.Pointer;
     }
 
     // At this point, 'external' contains the JavascriptExternal wrapper, obtained from either:
     // 1. This()->GetInternalField(0) if This() was the wrapped .NET object (PRIMARY)
-    // 2. Function data array if This() didn't have internal fields (FALLBACK)
+    // 2. mExternals, for the object recorded in the function data, if This() didn't have
+    //    internal fields (FALLBACK)
     // Now we can safely access the underlying .NET object and invoke the method
     System::Object^ self;
     try
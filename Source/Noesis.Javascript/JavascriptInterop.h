@@ -84,6 +84,10 @@ public:
 
 	static Local<Value> ConvertToV8(System::Object^ iObject);
 
+	static System::String^ ConvertStringFromV8(Local<String> iValue);
+
+	static Local<String> ConvertStringToV8(System::String^ iString);
+
 	static System::Object^ UnwrapObject(Local<Value> iValue);
 
 	static void Invoker(const v8::FunctionCallbackInfo<Value>& iArgs);
@@ -103,14 +107,24 @@ private:
 
     static Local<Date> ConvertDateTimeToV8(System::DateTime^ dateTime);
 
+    static System::Numerics::BigInteger^ ConvertBigIntFromV8(Local<BigInt> iValue);
+
+    static Local<BigInt> ConvertBigIntegerToV8(System::Numerics::BigInteger iValue);
+
     static System::Text::RegularExpressions::Regex^ ConvertRegexFromV8(Local<Value> iValue);
 
 	static v8::Local<v8::Value> ConvertFromSystemArray(System::Array^ iArray);
 
+	static System::Type^ GetTypedArrayElementType(System::Type^ type);
+
+	static v8::Local<v8::Value> ConvertToTypedArray(System::Object^ iObject, System::Type^ elementType);
+
     static v8::Local<v8::Value> ConvertFromSystemRegex(System::Text::RegularExpressions::Regex^ iRegex);
 
 	static v8::Local<v8::Value> ConvertFromSystemDictionary(System::Object^ iObject);
 
+	static v8::Local<v8::Value> ConvertKeyToV8(System::Object^ iKey);
+
 	static v8::Local<v8::Value> ConvertFromSystemList(System::Object^ iObject);
 
 	static v8::Local<v8::Value> ConvertFromSystemDelegate(System::Delegate^ iDelegate);
@@ -0,0 +1,145 @@
+#include <msclr\lock.h>
+
+#include "JavascriptMemoryCoordinator.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Noesis { namespace Javascript {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Finalized after every full .NET collection: it is only ever reachable from the finalization
+// queue, so each gen 2 collection finds it dead, and it resurrects itself for the next one.
+ref class FullCollectionSentinel
+{
+public:
+	!FullCollectionSentinel()
+	{
+		if (!JavascriptMemoryCoordinator::SentinelFinalized())
+			return;
+		JavascriptMemoryCoordinator::CheckMemoryLoad();
+		System::GC::ReRegisterForFinalize(this);
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void GCEpilogue(Isolate *isolate, GCType type, GCCallbackFlags flags, void *data)
+{
+	JavascriptMemoryCoordinator::UpdateMemoryPressure(isolate);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool JavascriptMemoryCoordinator::Enabled::get()
+{
+	return sEnabled;
+}
+
+void JavascriptMemoryCoordinator::Enabled::set(bool value)
+{
+	msclr::lock l(sIsolates);
+	// A sentinel left over from before the coordinator was last disabled carries on if it
+	// hasn't been finalized yet, rather than a second one being created.
+	if (value && !sSentinelAlive)
+	{
+		gcnew FullCollectionSentinel();
+		sSentinelAlive = true;
+	}
+	sEnabled = value;
+}
+
+long long JavascriptMemoryCoordinator::CriticalNotifications::get()
+{
+	return System::Threading::Interlocked::Read(sCriticalNotifications);
+}
+
+long long JavascriptMemoryCoordinator::ReportedMemoryPressure::get()
+{
+	return System::Threading::Interlocked::Read(sReportedTotal);
+}
+
+bool JavascriptMemoryCoordinator::SentinelFinalized()
+{
+	msclr::lock l(sIsolates);
+	if (!sEnabled)
+		sSentinelAlive = false;
+	return sEnabled;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void JavascriptMemoryCoordinator::AddIsolate(Isolate *isolate)
+{
+	isolate->AddGCEpilogueCallback(GCEpilogue);
+	msclr::lock l(sIsolates);
+	sIsolates->Add(System::IntPtr(isolate), 0);
+}
+
+void JavascriptMemoryCoordinator::RemoveIsolate(Isolate *isolate)
+{
+	isolate->RemoveGCEpilogueCallback(GCEpilogue);
+	long long reported;
+	{
+		msclr::lock l(sIsolates);
+		if (!sIsolates->TryGetValue(System::IntPtr(isolate), reported))
+			return;
+		sIsolates->Remove(System::IntPtr(isolate));
+		System::Threading::Interlocked::Add(sReportedTotal, -reported);
+	}
+	if (reported > 0)
+		System::GC::RemoveMemoryPressure(reported);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void JavascriptMemoryCoordinator::UpdateMemoryPressure(Isolate *isolate)
+{
+	// Every V8 collection gets here, so don't take the lock while there is nothing to do.
+	// A report that is being added concurrently is withdrawn by the next collection.
+	if (!sEnabled && System::Threading::Interlocked::Read(sReportedTotal) == 0)
+		return;
+
+	long long size = 0;
+	if (sEnabled)
+	{
+		HeapStatistics statistics;
+		isolate->GetHeapStatistics(&statistics);
+		size = (long long)(statistics.total_physical_size() + statistics.malloced_memory());
+	}
+
+	long long reported;
+	{
+		msclr::lock l(sIsolates);
+		if (!sIsolates->TryGetValue(System::IntPtr(isolate), reported) || reported == size)
+			return;
+		sIsolates[System::IntPtr(isolate)] = size;
+		System::Threading::Interlocked::Add(sReportedTotal, size - reported);
+	}
+	if (size > reported)
+		System::GC::AddMemoryPressure(size - reported);
+	else
+		System::GC::RemoveMemoryPressure(reported - size);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void JavascriptMemoryCoordinator::CheckMemoryLoad()
+{
+	System::GCMemoryInfo info = System::GC::GetGCMemoryInfo();
+	if (info.MemoryLoadBytes < info.HighMemoryLoadThresholdBytes)
+		return;
+
+	// Unlike most of V8's API, this may be called from any thread: V8 interrupts the isolate
+	// if it is busy on another one.  The lock stops the isolates from being disposed meanwhile.
+	msclr::lock l(sIsolates);
+	for each (System::IntPtr isolate in sIsolates->Keys)
+		((Isolate *)isolate.ToPointer())->MemoryPressureNotification(MemoryPressureLevel::kCritical);
+	System::Threading::Interlocked::Increment(sCriticalNotifications);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} } // namespace Noesis::Javascript
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,72 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+
+#include <v8.h>
+
+using namespace v8;
+
+//////////////////////////////////////////////////////////////////////////
+
+namespace Noesis { namespace Javascript {
+
+//////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////
+// JavascriptMemoryCoordinator
+//
+// Makes the .NET and V8 garbage collectors aware of each other, which
+// they otherwise aren't.  While enabled:
+//
+//  - After each full .NET collection that leaves the memory load above
+//    the GC's high memory load threshold (which honours container
+//    limits), every live isolate is sent a critical memory pressure
+//    notification, so that V8 collects too.
+//
+//  - After each V8 collection, the size of the isolate's heap is passed
+//    to GC.AddMemoryPressure()/RemoveMemoryPressure(), so that .NET
+//    collects sooner when V8 holds a lot of memory.
+//////////////////////////////////////////////////////////////////////////
+public ref class JavascriptMemoryCoordinator abstract sealed
+{
+public:
+	static property bool Enabled { bool get(); void set(bool value); }
+
+	// Number of times pressure from .NET has been forwarded to V8.
+	static property long long CriticalNotifications { long long get(); }
+
+	// Bytes currently passed to GC.AddMemoryPressure() on behalf of all
+	// isolates.  Reports are withdrawn by each isolate's next collection
+	// after the coordinator is disabled, or when its context is disposed.
+	static property long long ReportedMemoryPressure { long long get(); }
+
+internal:
+	// Called by JavascriptContext with the isolate locked.
+	static void AddIsolate(Isolate *isolate);
+	static void RemoveIsolate(Isolate *isolate);
+
+	static void UpdateMemoryPressure(Isolate *isolate);
+
+	static void CheckMemoryLoad();
+
+	// Called by the sentinel's finalizer; returns whether it should stay registered.
+	static bool SentinelFinalized();
+
+private:
+	// Bytes reported to GC.AddMemoryPressure() for each live isolate.
+	static System::Collections::Generic::Dictionary<System::IntPtr, long long>^ sIsolates =
+		gcnew System::Collections::Generic::Dictionary<System::IntPtr, long long>();
+
+	static bool sEnabled;
+	static bool sSentinelAlive;
+	static long long sCriticalNotifications;
+
+	// Sum of the values in sIsolates.  Updated under the lock, read without it.
+	static long long sReportedTotal;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+} } // namespace Noesis::Javascript
+
+//////////////////////////////////////////////////////////////////////////
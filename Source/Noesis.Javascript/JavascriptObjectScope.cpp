@@ -0,0 +1,47 @@
+#include "JavascriptObjectScope.h"
+#include "JavascriptExternal.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Noesis { namespace Javascript {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+JavascriptObjectScope::JavascriptObjectScope(JavascriptContext^ context, JavascriptObjectScope^ parent)
+{
+	mContext = context;
+	mParent = parent;
+	mObjects = gcnew System::Collections::Generic::List<System::Object^>();
+}
+
+JavascriptObjectScope::~JavascriptObjectScope()
+{
+	if (mObjects == nullptr)
+		return;
+
+	auto objects = mObjects;
+	mObjects = nullptr;
+	if (mContext->IsDisposed())
+		return;
+
+	JavascriptScope scope(mContext);
+	mContext->EndScope(this);
+	for each (System::Object^ object in objects)
+		mContext->ReleaseExternal(object);
+}
+
+int JavascriptObjectScope::Count::get()
+{
+	return mObjects != nullptr ? mObjects->Count : 0;
+}
+
+void JavascriptObjectScope::Track(System::Object^ iObject)
+{
+	mObjects->Add(iObject);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} } // namespace Noesis::Javascript
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,57 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+
+#include <v8.h>
+
+#include "JavascriptContext.h"
+
+using namespace v8;
+
+//////////////////////////////////////////////////////////////////////////
+
+namespace Noesis { namespace Javascript {
+
+//////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////
+// JavascriptObjectScope
+//
+// Returned by JavascriptContext.BeginScope().  Every .NET object that
+// gets its JavaScript object while the scope is open is released when
+// it is disposed, instead of whenever V8 gets round to collecting the
+// JavaScript object.  Scripts that kept the JavaScript objects get an
+// exception if they use them afterwards.
+//
+// Scopes can be nested; objects belong to the innermost one.  Objects
+// that already had a JavaScript object when the scope began are left
+// alone, as are delegates, which functions refer to directly.
+//////////////////////////////////////////////////////////////////////////
+public ref class JavascriptObjectScope
+{
+public:
+	~JavascriptObjectScope();
+
+	// Number of objects that will be released when the scope ends.
+	property int Count { int get(); }
+
+internal:
+	JavascriptObjectScope(JavascriptContext^ context, JavascriptObjectScope^ parent);
+
+	void Track(System::Object^ iObject);
+
+	property JavascriptObjectScope^ Parent { JavascriptObjectScope^ get() { return mParent; } }
+
+	property bool IsEnded { bool get() { return mObjects == nullptr; } }
+
+private:
+	JavascriptContext^ mContext;
+	JavascriptObjectScope^ mParent;
+	System::Collections::Generic::List<System::Object^>^ mObjects;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+} } // namespace Noesis::Javascript
+
+//////////////////////////////////////////////////////////////////////////
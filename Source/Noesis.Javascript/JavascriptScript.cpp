@@ -0,0 +1,58 @@
+#include "JavascriptScript.h"
+#include "JavascriptException.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Noesis { namespace Javascript {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+JavascriptScript::JavascriptScript(Local<UnboundScript> iScript, JavascriptContext^ context)
+{
+	mScriptHandle = new Persistent<UnboundScript>(context->GetCurrentIsolate(), iScript);
+	mContextHandle = gcnew System::WeakReference(context);
+}
+
+JavascriptScript::~JavascriptScript()
+{
+	if (mScriptHandle)
+	{
+		// Once the context is gone, so is the isolate and our handle with it.
+		auto context = GetContext();
+		if (context && !context->IsDisposed())
+		{
+			JavascriptScope scope(context);
+			mScriptHandle->Reset();
+			delete mScriptHandle;
+		}
+
+		mScriptHandle = nullptr;
+	}
+}
+
+JavascriptScript::!JavascriptScript()
+{
+	// Finalizers must not wait for a running script to release the isolate's lock, so the
+	// handle is released the next time the context is entered.
+	auto context = GetContext();
+	if (mScriptHandle && context && !context->IsDisposed())
+		context->mPendingScriptReleases->Enqueue(System::IntPtr(mScriptHandle));
+	mScriptHandle = nullptr;
+}
+
+System::Object^ JavascriptScript::Run()
+{
+	if (!IsAlive())
+		throw gcnew JavascriptException(L"This script's owning JavascriptContext has been disposed");
+
+	auto context = GetContext();
+	JavascriptScope scope(context);
+	auto isolate = context->GetCurrentIsolate();
+	HandleScope handleScope(isolate);
+
+	return context->RunCompiledScript(mScriptHandle->Get(isolate)->BindToCurrentContext());
+}
+
+} } // namespace Noesis::Javascript
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,47 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+
+#include <v8.h>
+
+#include "JavascriptContext.h"
+
+using namespace v8;
+
+//////////////////////////////////////////////////////////////////////////
+
+namespace Noesis { namespace Javascript {
+
+//////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////
+// JavascriptScript
+//
+// A script compiled by a JavascriptContext, which can be run in it any
+// number of times without compiling it again.  Callers must not dispose
+// of their JavascriptContext while they still have references to
+// JavascriptScripts.
+//////////////////////////////////////////////////////////////////////////
+public ref class JavascriptScript
+{
+public:
+	~JavascriptScript();
+	!JavascriptScript();
+
+	System::Object^ Run();
+
+internal:
+	JavascriptScript(Local<UnboundScript> iScript, JavascriptContext^ context);
+
+private:
+	Persistent<UnboundScript>* mScriptHandle;
+	System::WeakReference^ mContextHandle;
+	inline JavascriptContext^ GetContext() { return mContextHandle->IsAlive ? safe_cast<JavascriptContext^>(mContextHandle->Target) : nullptr; }
+	inline bool IsAlive() { auto context = GetContext(); return context != nullptr && !context->IsDisposed() && mScriptHandle != nullptr; }
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+} } // namespace Noesis::Javascript
+
+//////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,56 @@
+#include "JavascriptWasmModule.h"
+#include "JavascriptContext.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Noesis { namespace Javascript {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+JavascriptWasmModule::JavascriptWasmModule(const CompiledWasmModule &iModule)
+{
+	mModule = new CompiledWasmModule(iModule);
+}
+
+JavascriptWasmModule::~JavascriptWasmModule()
+{
+	this->!JavascriptWasmModule();
+}
+
+JavascriptWasmModule::!JavascriptWasmModule()
+{
+	// Only drops our reference to the native module, which is allowed on any thread.
+	delete mModule;
+	mModule = nullptr;
+}
+
+JavascriptWasmModule^ JavascriptWasmModule::Copy()
+{
+	CheckNotDisposed();
+	return gcnew JavascriptWasmModule(*mModule);
+}
+
+cli::array<unsigned char>^ JavascriptWasmModule::GetWireBytes()
+{
+	CheckNotDisposed();
+	MemorySpan<const uint8_t> wireBytes = mModule->GetWireBytesRef();
+	cli::array<unsigned char>^ result = gcnew cli::array<unsigned char>((int)wireBytes.size());
+	if (wireBytes.size() > 0)
+		System::Runtime::InteropServices::Marshal::Copy(System::IntPtr((void *)wireBytes.data()), result, 0, result->Length);
+	return result;
+}
+
+Local<Value> JavascriptWasmModule::ToV8(Isolate *isolate)
+{
+	CheckNotDisposed();
+	Local<WasmModuleObject> module;
+	if (!WasmModuleObject::FromCompiledModule(isolate, *mModule).ToLocal(&module))
+		throw gcnew System::InvalidOperationException("Could not create a WebAssembly.Module from the compiled module");
+	return module;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} } // namespace Noesis::Javascript
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
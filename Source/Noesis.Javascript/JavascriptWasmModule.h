@@ -0,0 +1,51 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+
+#include <v8.h>
+
+using namespace v8;
+
+//////////////////////////////////////////////////////////////////////////
+
+namespace Noesis { namespace Javascript {
+
+//////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////
+// JavascriptWasmModule
+//
+// A compiled WebAssembly module, created by
+// JavascriptContext.CompileWasmModule() or converted from a JS
+// WebAssembly.Module.  Its native code is not tied to any isolate:
+// passing it to a context creates a WebAssembly.Module there which shares
+// the code instead of compiling the module again.
+//////////////////////////////////////////////////////////////////////////
+public ref class JavascriptWasmModule
+{
+public:
+	~JavascriptWasmModule();
+	!JavascriptWasmModule();
+
+	// Copies the bytes the module was compiled from.
+	cli::array<unsigned char>^ GetWireBytes();
+
+internal:
+	JavascriptWasmModule(const CompiledWasmModule &iModule);
+
+	// Another object sharing the native module, which can be disposed of independently.
+	JavascriptWasmModule^ Copy();
+
+	Local<Value> ToV8(Isolate *isolate);
+
+private:
+	inline void CheckNotDisposed() { if (mModule == nullptr) throw gcnew System::ObjectDisposedException("JavascriptWasmModule"); }
+
+	CompiledWasmModule *mModule;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+} } // namespace Noesis::Javascript
+
+//////////////////////////////////////////////////////////////////////////
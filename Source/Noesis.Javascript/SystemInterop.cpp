@@ -341,10 +341,9 @@ SystemInterop::ConvertToSystemString(std::string iString)
 double
 SystemInterop::ConvertFromSystemDateTime(System::DateTime^ iDateTime) 
 {
-    System::DateTime^ startDate = gcnew System::DateTime(1970, 1, 1, 0, 0, 0, 0, System::DateTimeKind::Utc);
-	System::TimeSpan^ timespan = iDateTime->ToUniversalTime() - *startDate;
-
-	return timespan->TotalMilliseconds;
+    // Integer division truncates towards zero, just like the TimeClip V8 applies to time values.
+    System::DateTime utc = iDateTime->ToUniversalTime();
+    return static_cast<double>((utc.Ticks - System::DateTime::UnixEpoch.Ticks) / System::TimeSpan::TicksPerMillisecond);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,112 @@
+﻿using System;
+using System.IO;
+using System.Text;
+using System.Threading.Tasks;
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+using FluentAssertions;
+
+namespace Noesis.Javascript.Tests
+{
+    [TestClass]
+    public class CompileAsyncTests
+    {
+        private JavascriptContext _context = null!;
+
+        [TestInitialize]
+        public void SetUp()
+        {
+            _context = new JavascriptContext();
+        }
+
+        [TestCleanup]
+        public void TearDown()
+        {
+            _context.Dispose();
+        }
+
+        [TestMethod]
+        public async Task CompileFromTextReader()
+        {
+            var source = "var total = 0; for (var i = 0; i < 10000; i++) { total += i; } '\u20ac' + total";
+            using var script = await _context.CompileAsync(new StringReader(source), "total.js");
+
+            script.Run().Should().Be("\u20ac49995000");
+        }
+
+        [TestMethod]
+        public async Task CompileFromStream()
+        {
+            var source = "function f() { return 'gr\u00fc\u00df'; }" + new string(' ', 200000) + "f()";
+            using var script = await _context.CompileAsync(new MemoryStream(Encoding.UTF8.GetBytes(source)), "stream.js");
+
+            script.Run().Should().Be("gr\u00fc\u00df");
+        }
+
+        [TestMethod]
+        public async Task CompileFromStreamWithByteOrderMark()
+        {
+            var source = "function f() { return 'gr\u00fc\u00df'; }" + new string(' ', 200000) + "f.toString() + f()";
+            var bytes = new UTF8Encoding(true);
+            using var stream = new MemoryStream();
+            stream.Write(bytes.GetPreamble());
+            stream.Write(bytes.GetBytes(source));
+            stream.Position = 0;
+            using var script = await _context.CompileAsync(stream, "bom.js");
+
+            script.Run().Should().Be("function f() { return 'gr\u00fc\u00df'; }gr\u00fc\u00df");
+        }
+
+        [TestMethod]
+        public async Task ContextCanRunScriptsWhileCompiling()
+        {
+            var reader = new SlowReader("40 + 2");
+            var compilation = _context.CompileAsync(reader, "slow.js");
+
+            _context.Run("1 + 1").Should().Be(2);
+            reader.Release();
+            using var script = await compilation;
+            script.Run().Should().Be(42);
+        }
+
+        [TestMethod]
+        public async Task SyntaxErrorsFailTheTask()
+        {
+            Func<Task> action = () => _context.CompileAsync(new StringReader("1 +"), "broken.js");
+            (await action.Should().ThrowAsync<JavascriptException>()).Which.Source.Should().Be("broken.js");
+        }
+
+        [TestMethod]
+        public async Task ReadErrorsFailTheTask()
+        {
+            Func<Task> action = () => _context.CompileAsync(new FailingStream(), "failing.js");
+            await action.Should().ThrowAsync<IOException>().WithMessage("disk on fire");
+        }
+
+        // Returns its text only after Release() has been called.
+        private class SlowReader : TextReader
+        {
+            private readonly string _text;
+            private readonly TaskCompletionSource _released = new TaskCompletionSource();
+            private bool _done;
+
+            public SlowReader(string text) => _text = text;
+
+            public void Release() => _released.SetResult();
+
+            public override int Read(char[] buffer, int index, int count)
+            {
+                _released.Task.Wait();
+                if (_done)
+                    return 0;
+                _done = true;
+                _text.CopyTo(0, buffer, index, _text.Length);
+                return _text.Length;
+            }
+        }
+
+        private class FailingStream : MemoryStream
+        {
+            public override int Read(byte[] buffer, int offset, int count) => throw new IOException("disk on fire");
+        }
+    }
+}
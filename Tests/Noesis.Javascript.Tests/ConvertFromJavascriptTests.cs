@@ -131,6 +131,23 @@ namespace Noesis.Javascript.Tests
             _context.GetParameter("myString").Should().BeOfType<string>().Which.Should().Be("a\0\0b");
         }
 
+        [TestMethod]
+        public void ReadLongStrings()
+        {
+            _context.Run("'\u00e9'.repeat(100000)").Should().Be(new string('\u00e9', 100000));
+            _context.Run("'\u4e2d'.repeat(100000) + 'x'").Should().Be(new string('\u4e2d', 100000) + "x");
+        }
+
+        [TestMethod]
+        public void LongStringsOfTheSameLengthAreSeparateObjects()
+        {
+            string first = (string)_context.Run("'a'.repeat(1000)");
+            string second = (string)_context.Run("'b'.repeat(1000)");
+
+            first.Should().Be(new string('a', 1000));
+            second.Should().Be(new string('b', 1000));
+        }
+
         [TestMethod]
         public void ReadArray()
         {
@@ -175,6 +192,36 @@ namespace Noesis.Javascript.Tests
             regex.Should().BeOfType<Regex>().Which.Should().BeEquivalentTo(new Regex("abc", RegexOptions.ECMAScript | RegexOptions.IgnoreCase | RegexOptions.Multiline));
         }
 
+        [TestMethod]
+        public void ReadSameRegExpTwiceReusesRegex()
+        {
+            var first = _context.Run("/a+b/i");
+            var second = _context.Run("new RegExp('a+b', 'i')");
+            second.Should().BeSameAs(first);
+            _context.Run("/a+b/m").Should().NotBeSameAs(first);
+        }
+
+        [TestMethod]
+        public void ReadFrequentlyUsedRegExpIsCompiled()
+        {
+            _context.RegexCompilationThreshold = 2;
+
+            var first = (Regex)_context.Run("/a+b/");
+            first.Options.Should().NotHaveFlag(RegexOptions.Compiled);
+            var second = (Regex)_context.Run("/a+b/");
+            second.Options.Should().HaveFlag(RegexOptions.Compiled);
+            second.IsMatch("xaab").Should().BeTrue();
+        }
+
+        [TestMethod]
+        public void RegExpFlagsWithoutDotNetEquivalentSurviveRoundTrip()
+        {
+            var regex = _context.Run("/abc/gisy");
+            _context.SetParameter("val", regex);
+
+            _context.Run("val.flags").Should().Be("gisy");
+        }
+
         [TestMethod]
         public void ReadBigIntLiteral()
         {
@@ -197,6 +244,14 @@ namespace Noesis.Javascript.Tests
             bigInt.Should().BeOfType<BigInteger>().Which.Should().Be(expected);
         }
 
+        [TestMethod]
+        public void ReadLargeNegativeBigIntLiteral()
+        {
+            var bigInt = _context.Run("-(2n ** 127n) + 12345n");
+            var expected = -BigInteger.Pow(new BigInteger(2), 127) + 12345;
+            bigInt.Should().BeOfType<BigInteger>().Which.Should().Be(expected);
+        }
+
         [TestMethod]
         public void ReadObject()
         {
@@ -224,6 +279,31 @@ namespace Noesis.Javascript.Tests
             _context.GetParameter("UniString").Should().BeOfType<string>().Which.Should().Be("呵呵呵呵呵");
         }
 
+        [TestMethod]
+        public void ReadTypedArray()
+        {
+            using var buffer = _context.Run("new Float64Array([1.5, 2.5, 3.5]).subarray(1)").Should().BeOfType<JavascriptArrayBuffer>().Subject;
+
+            buffer.ElementType.Should().Be(typeof(double));
+            buffer.Length.Should().Be(2);
+            buffer.ByteLength.Should().Be(16);
+            buffer.ToArray().Should().BeOfType<double[]>().Which.Should().Equal(2.5, 3.5);
+            buffer.ToArray<long>().Should().Equal(BitConverter.DoubleToInt64Bits(2.5), BitConverter.DoubleToInt64Bits(3.5));
+        }
+
+        [TestMethod]
+        public void ReadArrayBufferSharesMemoryWithJavascript()
+        {
+            using var buffer = (JavascriptArrayBuffer)_context.Run("bytes = new Uint8Array(4); bytes.buffer");
+            buffer.ElementType.Should().Be(typeof(byte));
+
+            System.Runtime.InteropServices.Marshal.WriteByte(buffer.Data, 2, 42);
+            _context.Run("bytes[2]").Should().Be(42);
+
+            _context.SetParameter("passedBack", buffer);
+            _context.Run("passedBack instanceof ArrayBuffer && new Uint8Array(passedBack)[2] == 42").Should().Be(true);
+        }
+
         [TestMethod]
         public void SelfReferentialObjectDoesNotCauseStackOverflow()
         {
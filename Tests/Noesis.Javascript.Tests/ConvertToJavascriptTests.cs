@@ -1,5 +1,6 @@
 ﻿using System;
 using System.Collections.Generic;
+using System.Linq;
 using Microsoft.VisualStudio.TestTools.UnitTesting;
 using FluentAssertions;
 using System.Text.RegularExpressions;
@@ -191,6 +192,13 @@ namespace Noesis.Javascript.Tests
             _context.Run("val === 2n ** 222n").Should().BeOfType<bool>().Which.Should().BeTrue();
         }
 
+        [TestMethod]
+        public void SetLargeNegativeBigInt()
+        {
+            _context.SetParameter("val", -BigInteger.Pow(new BigInteger(2), 127) + 12345);
+            _context.Run("val === -(2n ** 127n) + 12345n").Should().BeOfType<bool>().Which.Should().BeTrue();
+        }
+
         [TestMethod]
         public void SetObject()
         {
@@ -249,6 +257,88 @@ namespace Noesis.Javascript.Tests
                                         ").Should().BeOfType<bool>().Which.Should().BeTrue();
         }
 
+        [TestMethod]
+        public void SetLargeDictionary()
+        {
+            var dictionary = Enumerable.Range(0, 1000).ToDictionary(i => i % 2 == 0 ? i.ToString() : "key" + i, i => i);
+            _context.SetParameter("dictionary", dictionary);
+
+            _context.Run("Object.keys(dictionary).length").Should().Be(1000);
+            _context.Run("dictionary['998'] + dictionary.key999").Should().Be(1997);
+            _context.Run("Object.getPrototypeOf(dictionary) === Object.prototype").Should().Be(true);
+        }
+
+        [TestMethod]
+        public void SetPrimitiveArrayAsCopiedTypedArray()
+        {
+            var values = new double[] { 1.5, 2.5, 3.5 };
+            _context.PrimitiveArrayConversion = TypedArrayConversion.Copy;
+            _context.SetParameter("values", values);
+
+            _context.Run("values instanceof Float64Array && values.length == 3 && values[1] == 2.5").Should().Be(true);
+            _context.Run("values[0] = 42");
+            values[0].Should().Be(1.5);
+        }
+
+        [TestMethod]
+        public void SetPrimitiveArrayAsSharedTypedArray()
+        {
+            var bytes = new byte[] { 1, 2, 3, 4 };
+            _context.PrimitiveArrayConversion = TypedArrayConversion.Share;
+            _context.SetParameter("bytes", bytes);
+            _context.SetParameter("slice", new Memory<byte>(bytes, 1, 2));
+
+            _context.Run("bytes instanceof Uint8Array && slice.length == 2 && slice[0] == 2").Should().Be(true);
+            _context.Run("bytes[3] = 40; slice[0] = 20;");
+            if (JavascriptContext.IsMemorySharingSupported)
+                bytes.Should().Equal(1, 20, 3, 40);
+            else
+                bytes.Should().Equal(1, 2, 3, 4);
+        }
+
+        [TestMethod]
+        public void SetDictionaryKeysWhileTheStringCacheEvicts()
+        {
+            _context.StringCacheSize = 2;
+            var rows = new List<Dictionary<string, object>>
+            {
+                new() { ["a"] = 1, ["b"] = 2 },
+                new() { ["c"] = 3, ["a"] = 4 },
+                new() { ["d"] = 5, ["b"] = 6, ["a"] = 7 },
+            };
+            _context.SetParameter("rows", rows);
+
+            _context.Run("rows.map(r => Object.keys(r).join('')).join(',')").Should().Be("ab,ca,dba");
+            _context.Run("rows[0].a + rows[1].a + rows[2].a").Should().Be(12);
+        }
+
+        [TestMethod]
+        public void SetLargeStringAsExternalString()
+        {
+            _context.ExternalStringThreshold = 1000;
+            var document = string.Concat(Enumerable.Repeat("<p>\u00fcber\0</p>", 1000));
+            _context.SetParameter("document", document);
+
+            _context.Run("document.length").Should().Be(document.Length);
+            _context.Run("document.slice(0, 10)").Should().Be(document.Substring(0, 10));
+            _context.Run("document").Should().Be(document);
+            _context.Run("/* " + new string(' ', 2000) + " */ document.indexOf('</p>', 5)").Should().Be(document.IndexOf("</p>", 5));
+        }
+
+        [TestMethod]
+        public void SetLargeNonLatin1StringsAsExternalStrings()
+        {
+            _context.ExternalStringThreshold = 1000;
+            var latin1 = new string('\u00ff', 1999);
+            _context.SetParameter("latin1", latin1);
+            _context.SetParameter("lateEuro", latin1 + "\u20ac");
+            _context.SetParameter("earlyEuro", "\u20ac" + latin1);
+
+            _context.Run("latin1").Should().Be(latin1);
+            _context.Run("lateEuro").Should().Be(latin1 + "\u20ac");
+            _context.Run("earlyEuro").Should().Be("\u20ac" + latin1);
+        }
+
         [TestMethod]
         public void SetDelegate()
         {
@@ -298,5 +388,78 @@ namespace Noesis.Javascript.Tests
 
             _context.Run("val == 125.25").Should().BeOfType<bool>().Which.Should().BeTrue();
         }
+
+        [TestMethod]
+        public void SetEqualObjectsAsDistinctObjects()
+        {
+            var first = new AlwaysEqual { Id = 1 };
+            _context.SetParameter("a", first);
+            _context.SetParameter("b", new AlwaysEqual { Id = 2 });
+            _context.SetParameter("c", first);
+
+            _context.Run("a.Id").Should().Be(1);
+            _context.Run("b.Id").Should().Be(2);
+            _context.Run("a === b").Should().Be(false);
+            _context.Run("a === c").Should().Be(true);
+            _context.ExternalCount.Should().Be(2);
+        }
+
+        [TestMethod]
+        public void SetObjectsWithExternalSizes()
+        {
+            _context.ExternalObjectSize = 1024;
+            _context.SetParameter("a", new AlwaysEqual { Id = 1 });
+            using (_context.BeginScope())
+            {
+                _context.SetParameter("b", new SizedObject());
+
+                _context.Run("a.Id + b.Length").Should().Be(65537);
+                _context.ExternalMemory.Should().Be(1024 + 65536);
+            }
+            _context.ExternalMemory.Should().Be(1024);
+
+            _context.SetParameter("a", null);
+            _context.Collect();
+            _context.ExternalMemory.Should().Be(0);
+        }
+
+        [TestMethod]
+        public void SizeHintThatThrowsLeavesNothingReported()
+        {
+            Action action = () => _context.SetParameter("a", new ThrowingSizeHint());
+
+            action.Should().Throw<InvalidOperationException>();
+            _context.ExternalMemory.Should().Be(0);
+            _context.Run("typeof a").Should().Be("undefined");
+        }
+
+        [TestMethod]
+        public void ExternalObjectSizeCannotBeNegative()
+        {
+            Action action = () => _context.ExternalObjectSize = -1;
+
+            action.Should().Throw<ArgumentOutOfRangeException>();
+        }
+
+        class SizedObject : IJavascriptSizeHint
+        {
+            public int Length => 65536;
+
+            public long JavascriptSize => Length;
+        }
+
+        class ThrowingSizeHint : IJavascriptSizeHint
+        {
+            public long JavascriptSize => throw new InvalidOperationException("no size");
+        }
+
+        class AlwaysEqual
+        {
+            public int Id { get; set; }
+
+            public override bool Equals(object? obj) => obj is AlwaysEqual;
+
+            public override int GetHashCode() => 0;
+        }
     }
 }
@@ -36,6 +36,17 @@ namespace Noesis.Javascript.Tests
             _context.Run("val.getUTCSeconds()").Should().BeOfType<int>().Which.Should().Be(0);
         }
 
+        [TestMethod]
+        public void ConversionsIgnoreScriptsReplacingDate()
+        {
+            _context.Run("Date = function() { throw new Error('replaced'); }; Date.prototype.getTimezoneOffset = null;");
+            var date = new DateTime(2010, 10, 10, 0, 0, 0, DateTimeKind.Utc);
+
+            _context.SetParameter("val", date);
+            var dateFromV8 = (DateTime)_context.Run("val");
+            dateFromV8.ToUniversalTime().Should().Be(date);
+        }
+
         [TestMethod]
         public void SetDateTimeLocal()
         {
@@ -91,6 +102,14 @@ namespace Noesis.Javascript.Tests
             dateAsReportedByV8.Should().Be(new DateTime(2010, 10, 10));
         }
 
+        [TestMethod]
+        public void CreateArrayOfDatesInJavaScript()
+        {
+            var dates = (object[])_context.Run("[new Date(1978, 5, 15), new Date(1972, 1, 29, 13, 45, 30, 250), new Date(2010, 9, 10)]");
+
+            dates.Should().Equal(new DateTime(1978, 6, 15), new DateTime(1972, 2, 29, 13, 45, 30, 250), new DateTime(2010, 10, 10));
+        }
+
         [TestMethod]
         public void SetDateTimeUtc_DateWhereTimezoneDatabaseIsImportant()
         {
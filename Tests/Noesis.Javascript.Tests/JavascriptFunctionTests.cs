@@ -1,6 +1,7 @@
 ﻿using System;
 using System.Collections.Generic;
 using System.Linq;
+using System.Runtime.CompilerServices;
 using FluentAssertions;
 using Microsoft.VisualStudio.TestTools.UnitTesting;
 
@@ -116,6 +117,179 @@ function test() {
     return 1;
 }".Trim());
         }
+
+        [TestMethod]
+        public void SameFunctionIsConvertedToSameObject()
+        {
+            _context.Run("a = function() {}; b = function() {};");
+
+            var a = _context.GetParameter("a");
+            _context.GetParameter("a").Should().BeSameAs(a);
+            _context.GetParameter("b").Should().NotBeSameAs(a);
+            _context.FunctionCount.Should().Be(2);
+        }
+
+        [TestMethod]
+        public void DisposedFunctionIsReplacedWhenConvertedAgain()
+        {
+            _context.Run("a = function() { return 1; }");
+            var function = (JavascriptFunction)_context.GetParameter("a");
+            function.Dispose();
+            _context.FunctionCount.Should().Be(0);
+
+            var again = (JavascriptFunction)_context.GetParameter("a");
+            again.Should().NotBeSameAs(function);
+            again.Call().Should().Be(1);
+            _context.FunctionCount.Should().Be(1);
+        }
+
+        [TestMethod]
+        public void FinalizedFunctionIsReleasedWhenTheContextIsEntered()
+        {
+            _context.Run("a = function() {}");
+            ConvertAndDropFunction();
+            GC.Collect();
+            GC.WaitForPendingFinalizers();
+
+            _context.PendingFunctionReleases.Should().Be(1);
+            _context.FunctionCount.Should().Be(1);
+
+            _context.Run("1");
+
+            _context.PendingFunctionReleases.Should().Be(0);
+            _context.FunctionCount.Should().Be(0);
+            _context.FunctionReleaseLatency.Should().BeGreaterThan(TimeSpan.Zero);
+        }
+
+        [MethodImpl(MethodImplOptions.NoInlining)]
+        private void ConvertAndDropFunction()
+        {
+            _context.GetParameter("a").Should().BeOfType<JavascriptFunction>();
+        }
+
+        [TestMethod]
+        public void PreparedFunctionConvertsTypedArguments()
+        {
+            var function = (JavascriptFunction)_context.Run("(flag, count, ratio, name) => [typeof flag, count + 1, ratio * 2, name].join()");
+            var invoker = function.Prepare(typeof(bool), typeof(int), typeof(double), typeof(string));
+
+            var args = new object[] { true, 41, 1.5, "x" };
+            invoker.Call(args).Should().Be("boolean,42,3,x");
+            args[1] = 1;
+            invoker.Call(args).Should().Be("boolean,2,3,x");
+        }
+
+        [TestMethod]
+        public void PreparedFunctionCanBeCalledWithThis()
+        {
+            var function = (JavascriptFunction)_context.Run("(function(suffix) { return this.name + suffix; })");
+            var invoker = function.Prepare(typeof(string));
+
+            invoker.CallWithThis(new Dictionary<string, object> { ["name"] = "Noesis" }, "!").Should().Be("Noesis!");
+        }
+
+        [TestMethod]
+        public void PreparedFunctionChecksTheArgumentCount()
+        {
+            var invoker = ((JavascriptFunction)_context.Run("(a, b) => a + b")).Prepare(typeof(int), typeof(int));
+
+            Action action = () => invoker.Call(1);
+            action.Should().Throw<ArgumentException>();
+        }
+
+        [TestMethod]
+        public void CallWithTypedArguments()
+        {
+            var function = (JavascriptFunction)_context.Run("(...args) => args.map(a => typeof a + ':' + a).join()");
+
+            function.Call(true).Should().Be("boolean:true");
+            function.Call(41, 1.5).Should().Be("number:41,number:1.5");
+            function.Call(4000000000u, 0.25f, "x").Should().Be("number:4000000000,number:0.25,string:x");
+            function.Call(1, false, DateTime.MinValue.Year, (object?)null).Should().Be("number:1,boolean:false,number:1,object:null");
+        }
+
+        [TestMethod]
+        public void CallWithManyArguments()
+        {
+            var function = (JavascriptFunction)_context.Run("(...numbers) => numbers.reduce((a, b) => a + b)");
+
+            function.Call(Enumerable.Range(1, 20).Cast<object>().ToArray()).Should().Be(210);
+        }
+
+        [TestMethod]
+        public void CallManyReportsErrorsPerCall()
+        {
+            var function = (JavascriptFunction)_context.Run("(a, b) => { if (b == 0) throw new Error('division by zero'); return a / b; }");
+            var argumentSets = Enumerable.Range(0, 1000).Select(i => new object[] { i * 2, i % 10 });
+
+            var results = function.CallMany(argumentSets);
+
+            results.Should().HaveCount(1000);
+            results[1].Value.Should().Be(2);
+            results[10].Succeeded.Should().BeFalse();
+            results[10].Error.Should().BeOfType<JavascriptException>().Which.Message.Should().Contain("division by zero");
+            results[11].Value.Should().Be(22);
+            results.Count(r => !r.Succeeded).Should().Be(100);
+        }
+
+        [TestMethod]
+        public void CallManySurvivesTheFunctionBeingDisposed()
+        {
+            JavascriptFunction? function = null;
+            _context.SetParameter("dispose", new Action(() => function!.Dispose()));
+            function = (JavascriptFunction)_context.Run("(i) => { if (i == 300) dispose(); return i; }");
+
+            var results = function.CallMany(Enumerable.Range(0, 600).Select(i => new object[] { i }));
+
+            results.Select(r => r.Value).Should().Equal(Enumerable.Range(0, 600).Cast<object>());
+            Action action = () => function.Call(1);
+            action.Should().Throw<JavascriptException>();
+        }
+
+        [TestMethod]
+        public void CallManyColumns()
+        {
+            var function = (JavascriptFunction)_context.Run("(price, quantity) => price * quantity");
+
+            var results = function.CallManyColumns(new[] { 1.5, 2.0, 4.0 }, new[] { 2, 3, 0 });
+
+            results.Select(r => r.Value).Should().Equal(3, 6, 0);
+        }
+
+        [TestMethod]
+        public void CallManyColumnsChecksLengths()
+        {
+            var function = (JavascriptFunction)_context.Run("(a, b) => a + b");
+
+            Action action = () => function.CallManyColumns(new[] { 1, 2 }, new[] { 3 });
+            action.Should().Throw<ArgumentException>();
+        }
+
+        [TestMethod]
+        public void CompileFunctionWithParameters()
+        {
+            var function = _context.CompileFunction("return price * quantity > limit;", "price", "quantity", "limit");
+
+            function.Call(2.5, 4, 9).Should().Be(true);
+            function.Call(2.5, 3, 9).Should().Be(false);
+            _context.GetParameter("price").Should().BeNull();
+        }
+
+        [TestMethod]
+        public void CompileFunctionCanUseGlobals()
+        {
+            _context.SetParameter("factor", 3);
+            var function = _context.CompileFunction("return x * factor;", new[] { "x" });
+
+            function.Call(14).Should().Be(42);
+        }
+
+        [TestMethod]
+        public void CompileFunctionWithSyntaxError()
+        {
+            Action action = () => _context.CompileFunction("return (x;", "x");
+            action.Should().Throw<JavascriptException>();
+        }
     }
 
     [TestClass]
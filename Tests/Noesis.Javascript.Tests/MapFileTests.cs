@@ -0,0 +1,111 @@
+﻿using System;
+using System.IO;
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+using FluentAssertions;
+
+namespace Noesis.Javascript.Tests
+{
+    [TestClass]
+    public class MapFileTests
+    {
+        private string _path = null!;
+
+        [TestInitialize]
+        public void SetUp()
+        {
+            _path = Path.GetTempFileName();
+            File.WriteAllBytes(_path, new byte[] { 1, 2, 3, 4 });
+        }
+
+        [TestCleanup]
+        public void TearDown()
+        {
+            GC.Collect();
+            GC.WaitForPendingFinalizers();
+            File.Delete(_path);
+        }
+
+        [TestMethod]
+        public void MappedFileCanBeSharedBetweenContexts()
+        {
+            using var file = JavascriptContext.MapFile(_path, true);
+            file.ByteLength.Should().Be(4);
+
+            using (var context1 = new JavascriptContext())
+            using (var context2 = new JavascriptContext())
+            {
+                context1.SetParameter("file", file);
+                context2.SetParameter("file", file);
+
+                context1.Run("new Uint8Array(file)[3]").Should().Be(4);
+                context2.Run("new Uint8Array(file).reduce((a, b) => a + b)").Should().Be(10);
+            }
+        }
+
+        [TestMethod]
+        public void WritesToReadOnlyMappingDoNotReachTheFile()
+        {
+            using (var file = JavascriptContext.MapFile(_path, true))
+            using (var context = new JavascriptContext())
+            {
+                context.SetParameter("file", file);
+                context.Run("new Uint8Array(file)[0] = 42");
+                context.Run("new Uint8Array(file)[0]").Should().Be(42);
+            }
+
+            File.ReadAllBytes(_path).Should().Equal(1, 2, 3, 4);
+        }
+
+        [TestMethod]
+        public void WritesToReadOnlyMappingStayInTheirContext()
+        {
+            using var file = JavascriptContext.MapFile(_path, true);
+            using (var context1 = new JavascriptContext())
+            using (var context2 = new JavascriptContext())
+            {
+                context1.SetParameter("file", file);
+                context2.SetParameter("file", file);
+
+                context1.Run("new Uint8Array(file)[0] = 42");
+                context2.Run("new Uint8Array(file)[0]").Should().Be(1);
+                file.ToArray<byte>().Should().Equal(1, 2, 3, 4);
+
+                // The context keeps its view while it holds on to the buffer.
+                context1.SetParameter("again", file);
+                context1.Run("new Uint8Array(again)[0]").Should().Be(42);
+            }
+        }
+
+        [TestMethod]
+        public void SeparateMappingsOfAFileDoNotShareWrites()
+        {
+            using (var file1 = JavascriptContext.MapFile(_path, true))
+            using (var file2 = JavascriptContext.MapFile(_path, true))
+            using (var context1 = new JavascriptContext())
+            using (var context2 = new JavascriptContext())
+            {
+                context1.SetParameter("file", file1);
+                context2.SetParameter("file", file2);
+
+                context1.Run("new Uint8Array(file)[0] = 42");
+                context2.Run("new Uint8Array(file)[0]").Should().Be(1);
+            }
+        }
+
+        [TestMethod]
+        public void MapEmptyFile()
+        {
+            File.WriteAllBytes(_path, new byte[0]);
+
+            using var file = JavascriptContext.MapFile(_path, true);
+            file.ByteLength.Should().Be(0);
+        }
+
+        [TestMethod]
+        public void MapMissingFile()
+        {
+            Action action = () => JavascriptContext.MapFile(_path + ".missing", true);
+            action.Should().Throw<FileNotFoundException>();
+        }
+    }
+}
@@ -1,5 +1,6 @@
 ﻿using System;
 using System.Diagnostics;
+using System.Runtime.CompilerServices;
 using Microsoft.VisualStudio.TestTools.UnitTesting;
 using FluentAssertions;
 
@@ -81,6 +82,125 @@ namespace Noesis.Javascript.Tests
             diffMBytes.Should().BeLessThan(3, $"x64 memory leak detected: {diffMBytes:0.00} MB still allocated");
         }
 
+        [TestMethod]
+        public void CallbackOfReachableHolderSurvivesCollect()
+        {
+            using (JavascriptContext ctx = new JavascriptContext())
+            {
+                var holder = new CallbackHolder();
+                ctx.SetParameter("holder", holder);
+                ctx.Run("holder.Callback = function() { return 42; }; holder = null;");
+
+                ctx.Collect();
+                GC.Collect();
+                GC.WaitForPendingFinalizers();
+                ctx.Collect();
+
+                holder.Callback!.Call().Should().Be(42);
+                ctx.FunctionCount.Should().Be(1);
+            }
+        }
+
+        [TestMethod]
+        public void ObjectReachedOnlyByTheCallbackOfAReachableHolderSurvivesCollect()
+        {
+            using (JavascriptContext ctx = new JavascriptContext())
+            {
+                var holder = new CallbackHolder();
+                ctx.SetParameter("holder", holder);
+                ctx.SetParameter("inner", new CallbackHolder());
+                ctx.Run("holder.Callback = (function(o) { return function() { return o; }; })(inner); holder = null; inner = null;");
+
+                ctx.Collect();
+                GC.Collect();
+                GC.WaitForPendingFinalizers();
+                ctx.Collect();
+
+                holder.Callback!.Call().Should().BeOfType<CallbackHolder>();
+            }
+        }
+
+        [TestMethod]
+        public void CycleThroughJavascriptFunctionIsCollected()
+        {
+            using (JavascriptContext ctx = new JavascriptContext())
+            {
+                WeakReference holder = CreateCycle(ctx);
+
+                ctx.Collect();
+
+                ctx.ExternalCount.Should().Be(0);
+                ctx.FunctionCount.Should().Be(0);
+                holder.IsAlive.Should().BeFalse();
+            }
+        }
+
+        [TestMethod]
+        public void CycleThatIsStillUsedSurvivesCollect()
+        {
+            using (JavascriptContext ctx = new JavascriptContext())
+            {
+                var holder = new CallbackHolder();
+                ctx.SetParameter("holder", holder);
+                ctx.Run("(function(h) { h.Callback = function() { return h; }; })(holder); holder = null;");
+
+                ctx.Collect();
+
+                holder.Callback!.Call().Should().BeSameAs(holder);
+                ctx.ExternalCount.Should().Be(1);
+                ctx.FunctionCount.Should().Be(1);
+            }
+        }
+
+        [TestMethod]
+        public void MemoryCoordinatorCanBeEnabledWhileContextsRun()
+        {
+            JavascriptMemoryCoordinator.Enabled = true;
+            try
+            {
+                using (JavascriptContext ctx = new JavascriptContext())
+                {
+                    ctx.Run("var a = []; for (var i = 0; i < 100000; i++) a.push({ i: i });");
+                    ctx.Collect();
+                    long reported = JavascriptMemoryCoordinator.ReportedMemoryPressure;
+                    reported.Should().BeGreaterThan(0);
+
+                    // Toggling before the sentinel has been finalized keeps the reports.
+                    JavascriptMemoryCoordinator.Enabled = false;
+                    JavascriptMemoryCoordinator.Enabled = true;
+                    GC.Collect();
+                    GC.WaitForPendingFinalizers();
+                    JavascriptMemoryCoordinator.ReportedMemoryPressure.Should().BeGreaterThan(0);
+
+                    ctx.Run("a.length").Should().Be(100000);
+
+                    JavascriptMemoryCoordinator.Enabled = false;
+                    ctx.Collect();
+                    JavascriptMemoryCoordinator.ReportedMemoryPressure.Should().Be(0);
+                }
+            }
+            finally
+            {
+                JavascriptMemoryCoordinator.Enabled = false;
+            }
+        }
+
+        // The .NET object holds a function that closes over the object's own JavaScript wrapper.
+        [MethodImpl(MethodImplOptions.NoInlining)]
+        private static WeakReference CreateCycle(JavascriptContext ctx)
+        {
+            var holder = new CallbackHolder();
+            ctx.SetParameter("holder", holder);
+            ctx.Run("(function(h) { h.Callback = function() { return h; }; })(holder); holder = null;");
+            holder.Callback.Should().NotBeNull();
+            return new WeakReference(holder);
+        }
+
+        class CallbackHolder
+        {
+            public JavascriptFunction? Callback { get; set; }
+        }
+
         private static void MemoryUsageLoadInstance()
         {
             using (JavascriptContext ctx = new JavascriptContext())
@@ -0,0 +1,149 @@
+﻿using System;
+using System.Collections.Generic;
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+using FluentAssertions;
+
+namespace Noesis.Javascript.Tests
+{
+    [TestClass]
+    public class ModuleTests
+    {
+        private JavascriptContext _context = null!;
+        private DictionaryResolver _resolver = null!;
+
+        [TestInitialize]
+        public void SetUp()
+        {
+            _context = new JavascriptContext();
+            _resolver = new DictionaryResolver();
+            _context.ModuleResolver = _resolver;
+        }
+
+        [TestCleanup]
+        public void TearDown()
+        {
+            _context.Dispose();
+        }
+
+        [TestMethod]
+        public void RunModuleWithDependencies()
+        {
+            _resolver.Modules["math"] = "export function add(a, b) { return a + b; }";
+            _resolver.Modules["main"] = "import { add } from 'math'; export const answer = add(40, 2);";
+
+            var exports = (Dictionary<string, object>)_context.RunModule("main");
+
+            exports["answer"].Should().Be(42);
+        }
+
+        [TestMethod]
+        public void SharedDependenciesAreLoadedOnce()
+        {
+            _resolver.Modules["counter"] = "globalThis.loads = (globalThis.loads || 0) + 1; export const n = 1;";
+            _resolver.Modules["a"] = "import { n } from 'counter'; export const a = n;";
+            _resolver.Modules["b"] = "import { n } from 'counter'; export const b = n;";
+
+            _context.RunModule("a");
+            _context.RunModule("b");
+
+            _context.Run("loads").Should().Be(1);
+            _resolver.Loads.Should().Be(3);
+        }
+
+        [TestMethod]
+        public void ModulesCanImportEachOther()
+        {
+            _resolver.Modules["even"] = "import { isOdd } from 'odd'; export function isEven(n) { return n == 0 || isOdd(n - 1); }";
+            _resolver.Modules["odd"] = "import { isEven } from 'even'; export function isOdd(n) { return n != 0 && isEven(n - 1); }";
+            _resolver.Modules["main"] = "import { isEven } from 'even'; export const result = isEven(10);";
+
+            var exports = (Dictionary<string, object>)_context.RunModule("main");
+
+            exports["result"].Should().Be(true);
+        }
+
+        [TestMethod]
+        public void ModuleCanBeRunAfterADependencyFailedToLoad()
+        {
+            _resolver.Modules["even"] = "import { isOdd } from 'odd'; export function isEven(n) { return n == 0 || isOdd(n - 1); }";
+            _resolver.Modules["odd"] = "import { isEven } from 'even'; export function isOdd(n) { return n != 0 && isEven(n - 1); }";
+            _resolver.Modules["main"] = "import { isEven } from 'even'; import { offset } from 'offset'; export const result = isEven(10 + offset);";
+
+            Action action = () => _context.RunModule("main");
+            action.Should().Throw<InvalidOperationException>().WithMessage("*offset*");
+
+            _resolver.Modules["offset"] = "export const offset = 1;";
+            var exports = (Dictionary<string, object>)_context.RunModule("main");
+
+            exports["result"].Should().Be(false);
+        }
+
+        [TestMethod]
+        public void ModulesCompiledByAnotherContextGiveTheSameResult()
+        {
+            _resolver.Modules["main"] = "export const value = [1, 2, 3].map(x => x * 2).join();";
+
+            ((Dictionary<string, object>)_context.RunModule("main"))["value"].Should().Be("2,4,6");
+            using (var other = new JavascriptContext { ModuleResolver = _resolver })
+                ((Dictionary<string, object>)other.RunModule("main"))["value"].Should().Be("2,4,6");
+        }
+
+        [TestMethod]
+        public void DynamicImportFromScript()
+        {
+            _resolver.Modules["lazy"] = "export default 'loaded';";
+
+            _context.Run("import('lazy').then(m => { globalThis.result = m.default; }); undefined");
+
+            _context.Run("result").Should().Be("loaded");
+        }
+
+        [TestMethod]
+        public void DynamicImportOfUnknownModuleRejects()
+        {
+            _context.Run("import('missing').catch(e => { globalThis.error = e.message; }); undefined");
+
+            _context.Run("error").Should().BeOfType<string>().Which.Should().Contain("missing");
+        }
+
+        [TestMethod]
+        public void ErrorsInModulesAreThrown()
+        {
+            _resolver.Modules["main"] = "throw new Error('broken module');";
+
+            Action action = () => _context.RunModule("main");
+
+            action.Should().Throw<JavascriptException>().WithMessage("*broken module*");
+        }
+
+        [TestMethod]
+        public void RunModuleWithoutResolver()
+        {
+            _context.ModuleResolver = null;
+
+            Action action = () => _context.RunModule("main");
+
+            action.Should().Throw<InvalidOperationException>();
+        }
+
+        private class DictionaryResolver : IModuleResolver
+        {
+            public Dictionary<string, string> Modules { get; } = new Dictionary<string, string>();
+
+            public int Loads { get; private set; }
+
+            public string Resolve(string specifier, string referrer)
+            {
+                if (!Modules.ContainsKey(specifier))
+                    throw new InvalidOperationException("Unknown module " + specifier);
+                return specifier;
+            }
+
+            public string Load(string identifier)
+            {
+                Loads++;
+                return Modules[identifier];
+            }
+        }
+    }
+}
@@ -0,0 +1,110 @@
+﻿using System;
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+using FluentAssertions;
+
+namespace Noesis.Javascript.Tests
+{
+    [TestClass]
+    public class ObjectScopeTests
+    {
+        private JavascriptContext _context = null!;
+
+        [TestInitialize]
+        public void SetUp()
+        {
+            _context = new JavascriptContext();
+        }
+
+        [TestCleanup]
+        public void TearDown()
+        {
+            _context.Dispose();
+        }
+
+        [TestMethod]
+        public void ObjectsAreReleasedWhenTheScopeEnds()
+        {
+            _context.SetParameter("before", new Item { Value = 1 });
+            using (var scope = _context.BeginScope())
+            {
+                _context.SetParameter("during", new Item { Value = 2 });
+                _context.Run("during.Value + before.Value").Should().Be(3);
+                scope.Count.Should().Be(1);
+                _context.ExternalCount.Should().Be(2);
+            }
+
+            _context.ExternalCount.Should().Be(1);
+            _context.Run("before.Value").Should().Be(1);
+        }
+
+        [TestMethod]
+        public void UsingAReleasedObjectThrows()
+        {
+            using (_context.BeginScope())
+            {
+                _context.SetParameter("item", new Item { Value = 2 });
+            }
+
+            Action getter = () => _context.Run("item.Value");
+            getter.Should().Throw<JavascriptException>().WithMessage("*released*");
+            Action method = () => _context.Run("item.Increment()");
+            method.Should().Throw<JavascriptException>().WithMessage("*released*");
+        }
+
+        [TestMethod]
+        public void MethodKeptAfterTheScopeDoesNotReachOtherObjects()
+        {
+            using (_context.BeginScope())
+            {
+                _context.SetParameter("item", new Item { Value = 1 });
+                _context.Run("var increment = item.Increment; increment.call(null)").Should().Be(2);
+            }
+
+            var other = new Item { Value = 10 };
+            using (_context.BeginScope())
+            {
+                _context.SetParameter("other", other);
+                Action action = () => _context.Run("increment.call(null)");
+                action.Should().Throw<JavascriptException>().WithMessage("*released*");
+                _context.Run("other.Increment()").Should().Be(11);
+            }
+            other.Value.Should().Be(11);
+        }
+
+        [TestMethod]
+        public void NestedScopes()
+        {
+            using (_context.BeginScope())
+            {
+                _context.SetParameter("outer", new Item { Value = 1 });
+                using (_context.BeginScope())
+                {
+                    _context.SetParameter("inner", new Item { Value = 2 });
+                }
+                _context.ExternalCount.Should().Be(1);
+                _context.Run("outer.Value").Should().Be(1);
+            }
+            _context.ExternalCount.Should().Be(0);
+        }
+
+        [TestMethod]
+        public void ObjectPassedAgainAfterItsScopeGetsANewJavaScriptObject()
+        {
+            var item = new Item { Value = 5 };
+            using (_context.BeginScope())
+            {
+                _context.SetParameter("item", item);
+            }
+
+            _context.SetParameter("item", item);
+            _context.Run("item.Increment()").Should().Be(6);
+        }
+
+        class Item
+        {
+            public int Value { get; set; }
+
+            public int Increment() => ++Value;
+        }
+    }
+}
@@ -0,0 +1,149 @@
+﻿using System;
+using System.IO;
+using System.Runtime.CompilerServices;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+using FluentAssertions;
+
+namespace Noesis.Javascript.Tests
+{
+    [TestClass]
+    public class RunFileTests
+    {
+        private string _path = null!;
+
+        [TestInitialize]
+        public void SetUp()
+        {
+            _path = Path.GetTempFileName();
+        }
+
+        [TestCleanup]
+        public void TearDown()
+        {
+            GC.Collect();
+            GC.WaitForPendingFinalizers();
+            File.Delete(_path);
+        }
+
+        [TestMethod]
+        public void RunAsciiFileInSeveralContexts()
+        {
+            File.WriteAllText(_path, "function add(a, b) { return a + b; } add(x, 2)", new UTF8Encoding(false));
+
+            using (var context1 = new JavascriptContext())
+            using (var context2 = new JavascriptContext())
+            {
+                context1.SetParameter("x", 1);
+                context2.SetParameter("x", 40);
+
+                context1.RunFile(_path).Should().Be(3);
+                context2.RunFile(_path).Should().Be(42);
+            }
+        }
+
+        [TestMethod]
+        public void RunUtf8File()
+        {
+            File.WriteAllText(_path, "'gr\u00fc\u00df \u20ac'", new UTF8Encoding(true));
+
+            using var context = new JavascriptContext();
+            context.RunFile(_path).Should().Be("gr\u00fc\u00df \u20ac");
+        }
+
+        [TestMethod]
+        public void RunUtf16File()
+        {
+            File.WriteAllText(_path, "'gr\u00fc\u00df \u20ac'", new UnicodeEncoding(false, true));
+
+            using var context = new JavascriptContext();
+            context.RunFile(_path).Should().Be("gr\u00fc\u00df \u20ac");
+        }
+
+        [TestMethod]
+        public void RunEmptyFile()
+        {
+            using var context = new JavascriptContext();
+            context.RunFile(_path).Should().BeNull();
+        }
+
+        [TestMethod]
+        public void RunChangedFile()
+        {
+            using var context = new JavascriptContext();
+            File.WriteAllText(_path, "1");
+            context.RunFile(_path).Should().Be(1);
+
+            File.WriteAllText(_path, "2 + 2");
+            File.SetLastWriteTimeUtc(_path, DateTime.UtcNow.AddMinutes(1));
+            context.RunFile(_path).Should().Be(4);
+        }
+
+        [TestMethod]
+        public void CompileFileOnceAndRunItTwice()
+        {
+            File.WriteAllText(_path, "++counter");
+
+            using var context = new JavascriptContext();
+            context.SetParameter("counter", 0);
+            using var script = context.CompileFile(_path);
+            context.GetParameter("counter").Should().Be(0);
+
+            script.Run().Should().Be(1);
+            script.Run().Should().Be(2);
+        }
+
+        [TestMethod]
+        public void FinalizingACompiledFileDoesNotWaitForRunningScripts()
+        {
+            File.WriteAllText(_path, "1");
+
+            using var context = new JavascriptContext();
+            using var started = new ManualResetEventSlim();
+            using var release = new ManualResetEventSlim();
+            context.SetParameter("wait", new Action(() => { started.Set(); release.Wait(); }));
+            CompileFileAndDropIt(context);
+
+            var running = Task.Run(() => context.Run("wait()"));
+            started.Wait();
+            try
+            {
+                var finalized = Task.Run(() => { GC.Collect(); GC.WaitForPendingFinalizers(); });
+                finalized.Wait(TimeSpan.FromSeconds(10)).Should().BeTrue();
+            }
+            finally
+            {
+                release.Set();
+                running.Wait();
+            }
+
+            context.RunFile(_path).Should().Be(1);
+        }
+
+        [MethodImpl(MethodImplOptions.NoInlining)]
+        private void CompileFileAndDropIt(JavascriptContext context)
+        {
+            context.CompileFile(_path).Run().Should().Be(1);
+        }
+
+        [TestMethod]
+        public void ErrorsMentionTheFile()
+        {
+            File.WriteAllText(_path, "\n\nthrow new Error('oops')");
+
+            using var context = new JavascriptContext();
+            Action action = () => context.RunFile(_path);
+            action.Should().Throw<JavascriptException>().Which.Line.Should().Be(3);
+        }
+
+        [TestMethod]
+        public void RunMissingFile()
+        {
+            using var context = new JavascriptContext();
+            Action action = () => context.RunFile(_path + ".missing");
+            action.Should().Throw<FileNotFoundException>();
+        }
+    }
+}
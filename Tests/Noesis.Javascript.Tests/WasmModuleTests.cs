@@ -0,0 +1,70 @@
+﻿using System;
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+using FluentAssertions;
+
+namespace Noesis.Javascript.Tests
+{
+    [TestClass]
+    public class WasmModuleTests
+    {
+        // (module (func (export "answer") (result i32) i32.const 42))
+        private static readonly byte[] AnswerModule =
+        {
+            0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00,
+            0x01, 0x05, 0x01, 0x60, 0x00, 0x01, 0x7f,
+            0x03, 0x02, 0x01, 0x00,
+            0x07, 0x0a, 0x01, 0x06, 0x61, 0x6e, 0x73, 0x77, 0x65, 0x72, 0x00, 0x00,
+            0x0a, 0x06, 0x01, 0x04, 0x00, 0x41, 0x2a, 0x0b
+        };
+
+        [TestMethod]
+        public void CompiledModuleCanBeUsedByOtherContexts()
+        {
+            using var context1 = new JavascriptContext();
+            var module = context1.CompileWasmModule(AnswerModule);
+
+            using var context2 = new JavascriptContext();
+            context2.SetParameter("module", module);
+            context2.Run("module instanceof WebAssembly.Module").Should().Be(true);
+            context2.Run("new WebAssembly.Instance(module).exports.answer()").Should().Be(42);
+        }
+
+        [TestMethod]
+        public void DisposingAModuleDoesNotAffectOtherCompilationsOfTheSameBytes()
+        {
+            using var context1 = new JavascriptContext();
+            using var context2 = new JavascriptContext();
+            var module1 = context1.CompileWasmModule(AnswerModule);
+            using var module2 = context2.CompileWasmModule((byte[])AnswerModule.Clone());
+            module2.Should().NotBeSameAs(module1);
+
+            module1.Dispose();
+
+            context2.SetParameter("module", module2);
+            context2.Run("new WebAssembly.Instance(module).exports.answer()").Should().Be(42);
+            using var module3 = context1.CompileWasmModule(AnswerModule);
+            module3.GetWireBytes().Should().Equal(AnswerModule);
+        }
+
+        [TestMethod]
+        public void ModulesCompiledByScriptsCanBePassedOn()
+        {
+            using var context1 = new JavascriptContext();
+            context1.SetParameter("bytes", AnswerModule);
+            var module = context1.Run("new WebAssembly.Module(new Uint8Array(bytes))").Should().BeOfType<JavascriptWasmModule>().Subject;
+            module.GetWireBytes().Should().Equal(AnswerModule);
+
+            using var context2 = new JavascriptContext();
+            context2.SetParameter("module", module);
+            context2.Run("new WebAssembly.Instance(module).exports.answer()").Should().Be(42);
+        }
+
+        [TestMethod]
+        public void InvalidBytesAreRejected()
+        {
+            using var context = new JavascriptContext();
+            Action action = () => context.CompileWasmModule(new byte[] { 1, 2, 3 });
+            action.Should().Throw<JavascriptException>();
+        }
+    }
+}